@@ -0,0 +1,117 @@
+/*
+ * FFT and spectrum analyzer benchmark
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "../dsp/spectrum.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// -------------------------------
+
+static const uint64_t kSamplesPerRun = 1 << 23;
+static const double   kSampleRate    = 48000.0;
+
+static double now_ns()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main()
+{
+    static const uint32_t kMaxSize = SpectrumAnalyzer::kMaxSize;
+
+    float* const input  = new float[kMaxSize*2];
+    float* const output = new float[kMaxSize+2];
+
+    std::srand(1);
+
+    for (uint32_t i=0; i < kMaxSize*2; ++i)
+        input[i] = float(std::rand()) / float(RAND_MAX) * 1.8f - 0.9f;
+
+    // sanity check, a full-scale 1 kHz sine must read 0 dB near 1 kHz
+    {
+        SpectrumAnalyzer analyzer;
+        analyzer.init(kSampleRate, 8192);
+
+        float* const sine = new float[48000];
+
+        for (uint32_t i=0; i < 48000; ++i)
+            sine[i] = std::sin(2.0 * M_PI * 1000.0 * i / kSampleRate);
+
+        analyzer.addSamples(sine, 48000);
+        delete[] sine;
+
+        uint32_t loudest = 0;
+
+        for (uint32_t i=1; i < analyzer.getBands(); ++i)
+        {
+            if (analyzer.getBandLevel(i) > analyzer.getBandLevel(loudest))
+                loudest = i;
+        }
+
+        if (std::fabs(analyzer.getBandLevel(loudest)) > 0.5f || std::fabs(analyzer.getBandFrequency(loudest) - 1000.0f) > 50.0f)
+        {
+            std::fprintf(stderr, "fft: 1 kHz sine measured %.2f dB at %.0f Hz\n",
+                         analyzer.getBandLevel(loudest), analyzer.getBandFrequency(loudest));
+            return 1;
+        }
+    }
+
+    // one analyzer instance at 50% overlap runs sampleRate/(size/2) frames per second
+    std::printf("fft: cost per frame and analyzer instances one core sustains at %.0f Hz\n", kSampleRate);
+    std::printf("%6s %12s %12s %12s\n", "size", "fft (us)", "frame (us)", "instances");
+
+    for (uint32_t size=SpectrumAnalyzer::kMinSize; size <= kMaxSize; size *= 2)
+    {
+        RealFFT fft;
+        fft.init(size);
+
+        const uint64_t iterations = kSamplesPerRun / size;
+
+        double start = now_ns();
+
+        for (uint64_t i=0; i < iterations; ++i)
+            fft.forward(input + (i & 1), output);
+
+        const double fftNs = (now_ns() - start) / double(iterations);
+
+        // full analyzer path: windowing, FFT and band smoothing
+        SpectrumAnalyzer analyzer;
+        analyzer.init(kSampleRate, size);
+
+        uint64_t frames = 0;
+        start = now_ns();
+
+        for (uint64_t i=0; i < iterations*2; ++i)
+        {
+            if (analyzer.addSamples(input, size/2))
+                ++frames;
+        }
+
+        const double frameNs = (now_ns() - start) / double(frames);
+        const double framesPerSecond = kSampleRate / double(size/2);
+
+        std::printf("%6u %12.1f %12.1f %12.0f\n", size, fftNs / 1000.0, frameNs / 1000.0, 1e9 / (frameNs * framesPerSecond));
+    }
+
+    delete[] input;
+    delete[] output;
+
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * jackmeter process callback benchmark
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "synthetic_jack.hpp"
+#include "../jackmeter/meterengine.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// -------------------------------
+// Runs MeterEngine::process(), the whole of jackmeter's process callback,
+// against synthetic ports filled with noise. The GUI side is simulated by
+// draining every ring buffer after each cycle, which is part of the timing.
+// Each result is the best of kRepeats runs, so it is stable across commits.
+
+static const uint64_t kFramesPerRun = 1 << 21;
+static const uint32_t kRepeats      = 5;
+static const uint32_t kMaxFrames    = 4096;
+static const double   kSampleRate   = 48000.0;
+
+enum Features {
+    FEATURE_PEAK,
+    FEATURE_TRUE_PEAK,
+    FEATURE_LOUDNESS,
+    FEATURE_VIEWS,
+    FEATURE_COUNT
+};
+
+static const char* const kFeatureNames[FEATURE_COUNT] = {
+    "peak",
+    "truepeak",
+    "loudness",
+    "views"
+};
+
+static double now_ns()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double bench_engine(const Features features, const uint32_t channels, const uint32_t frames)
+{
+    synthetic_jack_init(kMaxFrames);
+
+    MeterEngine engine;
+
+    if (! engine.registerPorts(synthetic_jack_get_client(), channels))
+        return 0.0;
+
+    switch (features)
+    {
+    case FEATURE_PEAK:
+        break;
+    case FEATURE_TRUE_PEAK:
+        engine.enableTruePeak();
+        break;
+    case FEATURE_LOUDNESS:
+        engine.enableLoudness(kSampleRate);
+        break;
+    case FEATURE_VIEWS:
+        engine.enableHistory();
+        engine.enableSpectrum();
+        engine.enableStereoScope(1);
+        break;
+    case FEATURE_COUNT:
+        break;
+    }
+
+    std::srand(1);
+
+    for (uint32_t c=0; c < channels; ++c)
+    {
+        float* const buffer((float*)jackbridge_port_get_buffer(engine.getPort(c), kMaxFrames));
+
+        for (uint32_t i=0; i < kMaxFrames; ++i)
+            buffer[i] = float(std::rand()) / float(RAND_MAX) * 1.8f - 0.9f;
+    }
+
+    const uint64_t iterations = kFramesPerRun / frames;
+    double best = 0.0;
+
+    for (uint32_t r=0; r < kRepeats; ++r)
+    {
+        const double start = now_ns();
+
+        for (uint64_t i=0; i < iterations; ++i)
+        {
+            engine.process(frames);
+
+            for (uint32_t c=0; c < channels; ++c)
+                engine.getPeaks().collect(c);
+
+            engine.getLoudnessBlocks().skip();
+            engine.getHistoryRecords().skip();
+            engine.getSpectrumSamples().skip();
+            engine.getStereoSums().skip();
+            engine.getGoniometerPoints().skip();
+        }
+
+        const double perFrame = (now_ns() - start) / double(iterations * frames);
+
+        if (r == 0 || perFrame < best)
+            best = perFrame;
+    }
+
+    return best;
+}
+
+static uint32_t get_arg(const int argc, char* argv[], const char* const name)
+{
+    for (int i=1; i+1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], name) == 0)
+            return uint32_t(std::atoi(argv[i+1]));
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // '-frames N' and '-channels N' run a single size instead of the sweep
+    const uint32_t onlyFrames   = get_arg(argc, argv, "-frames");
+    const uint32_t onlyChannels = get_arg(argc, argv, "-channels");
+
+    if (onlyFrames > kMaxFrames || onlyChannels > MeterEngine::kMaxChannels)
+    {
+        std::fprintf(stderr, "jackmeter: at most %u frames and %u channels\n", kMaxFrames, MeterEngine::kMaxChannels);
+        return 1;
+    }
+
+    static const uint32_t kChannelSweep[] = { 2, 8, 64 };
+
+    std::printf("jackmeter: process callback cost per frame (ns)\n");
+    std::printf("each column is peak metering plus only the named feature, they do not add up\n");
+
+    for (uint32_t c=0; c < 3; ++c)
+    {
+        const uint32_t channels = (onlyChannels > 0) ? onlyChannels : kChannelSweep[c];
+
+        std::printf("%3u ch %6s", channels, "frames");
+
+        for (int f=0; f < FEATURE_COUNT; ++f)
+            std::printf(" %10s", kFeatureNames[f]);
+
+        std::printf("\n");
+
+        for (uint32_t frames=64; frames <= 2048; frames *= 2)
+        {
+            if (onlyFrames > 0)
+                frames = onlyFrames;
+
+            std::printf("%7s %5u", "", frames);
+
+            for (int f=0; f < FEATURE_COUNT; ++f)
+                std::printf(" %10.2f", bench_engine(Features(f), channels, frames));
+
+            std::printf("\n");
+
+            if (onlyFrames > 0)
+                break;
+        }
+
+        if (onlyChannels > 0)
+            break;
+    }
+
+    synthetic_jack_init(0);
+    return 0;
+}
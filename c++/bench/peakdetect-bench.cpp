@@ -0,0 +1,131 @@
+/*
+ * Peak detection micro-benchmark
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "../dsp/peakdetect.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// -------------------------------
+// the loop jackmeter used before the SIMD kernels
+
+static volatile double gLegacyPeak = 0.0;
+
+static void legacy_loop(const float* const buffer, const uint32_t frames)
+{
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        if (std::abs(buffer[i]) > gLegacyPeak)
+            gLegacyPeak = std::abs(buffer[i]);
+    }
+}
+
+// -------------------------------
+
+static const uint64_t kFramesPerRun = 1 << 26;
+
+static double now_ns()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double bench_legacy(const float* const buffer, const uint32_t frames)
+{
+    const uint64_t iterations = kFramesPerRun / frames;
+    const double start = now_ns();
+
+    for (uint64_t i=0; i < iterations; ++i)
+    {
+        gLegacyPeak = 0.0;
+        legacy_loop(buffer, frames);
+    }
+
+    return (now_ns() - start) / double(iterations * frames);
+}
+
+static double bench_kernel(const PeakDetectFunc func, const float* const buffer, const uint32_t frames, float& result)
+{
+    const uint64_t iterations = kFramesPerRun / frames;
+    volatile float sink = 0.0f;
+    const double start = now_ns();
+
+    for (uint64_t i=0; i < iterations; ++i)
+        sink = func(buffer, frames, 0.0f);
+
+    const double elapsed = now_ns() - start;
+    result = sink;
+    return elapsed / double(iterations * frames);
+}
+
+int main()
+{
+    static const uint32_t kMaxFrames = 4096;
+    float* const buffer = new float[kMaxFrames];
+
+    std::srand(1);
+
+    for (uint32_t i=0; i < kMaxFrames; ++i)
+        buffer[i] = float(std::rand()) / float(RAND_MAX) * 1.8f - 0.9f;
+
+    std::printf("peakdetect: runtime dispatch picked '%s'\n", peakdetect_get_impl_name(peakdetect_get_impl()));
+    std::printf("%6s %10s", "frames", "legacy");
+
+    for (int impl=0; impl < PEAK_DETECT_COUNT; ++impl)
+        std::printf(" %10s", peakdetect_get_impl_name(PeakDetectImpl(impl)));
+
+    std::printf("   (ns/frame, speedup vs legacy)\n");
+
+    for (uint32_t frames=16; frames <= kMaxFrames; frames *= 2)
+    {
+        const double legacy = bench_legacy(buffer, frames);
+        std::printf("%6u %10.3f", frames, legacy);
+
+        for (int impl=0; impl < PEAK_DETECT_COUNT; ++impl)
+        {
+            const PeakDetectFunc func = peakdetect_get_func(PeakDetectImpl(impl));
+
+            if (func == nullptr)
+            {
+                std::printf(" %10s", "n/a");
+                continue;
+            }
+
+            float result;
+            const double nsPerFrame = bench_kernel(func, buffer, frames, result);
+
+            gLegacyPeak = 0.0;
+            legacy_loop(buffer, frames);
+
+            if (result != float(gLegacyPeak))
+            {
+                std::fprintf(stderr, "peakdetect: '%s' returned %f instead of %f for %u frames\n",
+                             peakdetect_get_impl_name(PeakDetectImpl(impl)), result, float(gLegacyPeak), frames);
+                delete[] buffer;
+                return 1;
+            }
+
+            std::printf(" %6.3f/%2.0fx", nsPerFrame, legacy / nsPerFrame);
+        }
+
+        std::printf("\n");
+    }
+
+    delete[] buffer;
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Synthetic JackBridge backend for benchmarks
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "synthetic_jack.hpp"
+
+#include <cstring>
+
+// -------------------------------
+
+struct SyntheticMidiBuffer {
+    uint32_t          count;
+    uint32_t          dataUsed;
+    jack_nframes_t    times[kSyntheticMaxMidiEvents];
+    uint32_t          sizes[kSyntheticMaxMidiEvents];
+    uint32_t          offsets[kSyntheticMaxMidiEvents];
+    jack_midi_data_t  data[kSyntheticMaxMidiEvents*4];
+};
+
+struct _jack_port {
+    char   name[64];
+    bool   isMidi;
+    float* audio;
+    SyntheticMidiBuffer* midi;
+};
+
+static jack_port_t gPorts[kSyntheticMaxPorts];
+static uint32_t    gPortCount = 0;
+static uint32_t    gMaxFrames = 0;
+static char        gClient;
+
+static void clear_ports()
+{
+    for (uint32_t i=0; i < gPortCount; ++i)
+    {
+        delete[] gPorts[i].audio;
+        delete gPorts[i].midi;
+    }
+
+    gPortCount = 0;
+}
+
+void synthetic_jack_init(const uint32_t maxFrames)
+{
+    clear_ports();
+    gMaxFrames = maxFrames;
+}
+
+jack_client_t* synthetic_jack_get_client()
+{
+    return (jack_client_t*)&gClient;
+}
+
+jack_port_t* synthetic_jack_get_port(const char* const name)
+{
+    for (uint32_t i=0; i < gPortCount; ++i)
+    {
+        if (std::strcmp(gPorts[i].name, name) == 0)
+            return &gPorts[i];
+    }
+
+    return nullptr;
+}
+
+bool synthetic_jack_set_midi_input(jack_port_t* const port, const jack_midi_data_t* const data, const uint32_t count, const uint32_t frames)
+{
+    if (port == nullptr || ! port->isMidi || count > kSyntheticMaxMidiEvents)
+        return false;
+
+    SyntheticMidiBuffer* const midi(port->midi);
+
+    for (uint32_t i=0; i < count; ++i)
+    {
+        midi->times[i]   = jack_nframes_t(uint64_t(i) * frames / count);
+        midi->sizes[i]   = 3;
+        midi->offsets[i] = i*3;
+        std::memcpy(midi->data + i*3, data + i*3, 3);
+    }
+
+    midi->count    = count;
+    midi->dataUsed = count*3;
+    return true;
+}
+
+uint32_t synthetic_jack_get_midi_output_count(jack_port_t* const port)
+{
+    return (port != nullptr && port->isMidi) ? port->midi->count : 0;
+}
+
+// -------------------------------
+// JackBridge calls
+
+jack_port_t* jackbridge_port_register(jack_client_t*, const char* port_name, const char* port_type, unsigned long, unsigned long)
+{
+    if (gPortCount == kSyntheticMaxPorts)
+        return nullptr;
+
+    jack_port_t* const port(&gPorts[gPortCount++]);
+
+    std::strncpy(port->name, port_name, 63);
+    port->name[63] = '\0';
+    port->isMidi   = (std::strcmp(port_type, JACK_DEFAULT_MIDI_TYPE) == 0);
+    port->audio    = nullptr;
+    port->midi     = nullptr;
+
+    if (port->isMidi)
+    {
+        port->midi = new SyntheticMidiBuffer;
+        port->midi->count    = 0;
+        port->midi->dataUsed = 0;
+    }
+    else
+    {
+        port->audio = new float[gMaxFrames];
+        std::memset(port->audio, 0, sizeof(float)*gMaxFrames);
+    }
+
+    return port;
+}
+
+void* jackbridge_port_get_buffer(jack_port_t* port, jack_nframes_t)
+{
+    if (port == nullptr)
+        return nullptr;
+
+    return port->isMidi ? (void*)port->midi : (void*)port->audio;
+}
+
+uint32_t jackbridge_midi_get_event_count(void* port_buffer)
+{
+    return ((SyntheticMidiBuffer*)port_buffer)->count;
+}
+
+bool jackbridge_midi_event_get(jack_midi_event_t* event, void* port_buffer, uint32_t event_index)
+{
+    SyntheticMidiBuffer* const midi((SyntheticMidiBuffer*)port_buffer);
+
+    if (event_index >= midi->count)
+        return false;
+
+    event->time   = midi->times[event_index];
+    event->size   = midi->sizes[event_index];
+    event->buffer = midi->data + midi->offsets[event_index];
+    return true;
+}
+
+void jackbridge_midi_clear_buffer(void* port_buffer)
+{
+    SyntheticMidiBuffer* const midi((SyntheticMidiBuffer*)port_buffer);
+
+    midi->count    = 0;
+    midi->dataUsed = 0;
+}
+
+bool jackbridge_midi_event_write(void* port_buffer, jack_nframes_t time, const jack_midi_data_t* data, size_t data_size)
+{
+    SyntheticMidiBuffer* const midi((SyntheticMidiBuffer*)port_buffer);
+
+    if (midi->count == kSyntheticMaxMidiEvents || midi->dataUsed + data_size > sizeof(midi->data))
+        return false;
+
+    midi->times[midi->count]   = time;
+    midi->sizes[midi->count]   = uint32_t(data_size);
+    midi->offsets[midi->count] = midi->dataUsed;
+    std::memcpy(midi->data + midi->dataUsed, data, data_size);
+
+    midi->dataUsed += uint32_t(data_size);
+    ++midi->count;
+    return true;
+}
@@ -0,0 +1,48 @@
+/*
+ * Synthetic JackBridge backend for benchmarks
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __SYNTHETIC_JACK_HPP__
+#define __SYNTHETIC_JACK_HPP__
+
+#include "../jackbridge/JackBridge.hpp"
+
+// -------------------------------
+// Linked instead of JackBridge.o, so realtime engines run without a server.
+// Only the port and MIDI buffer calls used inside process callbacks exist.
+// Every port gets its buffer when registered and keeps it, so the timed
+// loops never allocate. Audio inputs hold whatever the benchmark wrote into
+// them, MIDI inputs replay the same events every cycle.
+
+static const uint32_t kSyntheticMaxPorts      = 512;
+static const uint32_t kSyntheticMaxMidiEvents = 4096;
+
+// not realtime safe, drops all ports; call before registering any
+void synthetic_jack_init(uint32_t maxFrames);
+
+// a handle to pass to the engines, never dereferenced
+jack_client_t* synthetic_jack_get_client();
+
+// short name as given to jackbridge_port_register, or nullptr
+jack_port_t* synthetic_jack_get_port(const char* name);
+
+// 'count' events of 3 bytes, spread evenly over 'frames'; returns false if they do not fit
+bool synthetic_jack_set_midi_input(jack_port_t* port, const jack_midi_data_t* data, uint32_t count, uint32_t frames);
+
+// events written into a MIDI output since its last clear
+uint32_t synthetic_jack_get_midi_output_count(jack_port_t* port);
+
+#endif // __SYNTHETIC_JACK_HPP__
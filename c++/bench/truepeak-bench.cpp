@@ -0,0 +1,124 @@
+/*
+ * True-peak detection benchmark
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "../dsp/truepeak.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// -------------------------------
+
+static const uint32_t kChannels     = 8;
+static const uint64_t kFramesPerRun = 1 << 22;
+static const double   kSampleRate   = 48000.0;
+
+static double now_ns()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main()
+{
+    static const uint32_t kMaxFrames = 4096;
+
+    float* buffers[kChannels];
+    float  peaks[kChannels];
+
+    std::srand(1);
+
+    for (uint32_t c=0; c < kChannels; ++c)
+    {
+        buffers[c] = new float[kMaxFrames];
+
+        for (uint32_t i=0; i < kMaxFrames; ++i)
+            buffers[c][i] = float(std::rand()) / float(RAND_MAX) * 1.8f - 0.9f;
+    }
+
+    // sanity check, a fs/4 sine sampled at +-45 degrees has its true-peak 3 dB above its sample peak
+    {
+        float sine[1024];
+        const float* sineBuffers[1] = { sine };
+
+        for (uint32_t i=0; i < 1024; ++i)
+            sine[i] = std::sin(M_PI/2.0 * i + M_PI/4.0);
+
+        for (int impl=0; impl < TruePeakDetector::IMPL_COUNT; ++impl)
+        {
+            TruePeakDetector detector;
+            detector.init(1);
+
+            if (! detector.setImpl(TruePeakDetector::Impl(impl)))
+                continue;
+
+            float peak;
+            detector.process(sineBuffers, 1024, &peak);
+
+            if (std::fabs(20.0f * std::log10(peak)) > 0.2f)
+            {
+                std::fprintf(stderr, "truepeak: '%s' measured %.2f dBTP instead of 0.0\n",
+                             TruePeakDetector::getImplName(TruePeakDetector::Impl(impl)), 20.0f * std::log10(peak));
+                return 1;
+            }
+        }
+    }
+
+    std::printf("truepeak: cost per channel per cycle at %.0f Hz (ns, %% of the cycle)\n", kSampleRate);
+    std::printf("%6s", "frames");
+
+    for (int impl=0; impl < TruePeakDetector::IMPL_COUNT; ++impl)
+        std::printf(" %18s", TruePeakDetector::getImplName(TruePeakDetector::Impl(impl)));
+
+    std::printf("\n");
+
+    for (uint32_t frames=32; frames <= kMaxFrames; frames *= 2)
+    {
+        const uint64_t iterations = kFramesPerRun / frames / kChannels;
+        const double cycleNs = double(frames) / kSampleRate * 1e9;
+
+        std::printf("%6u", frames);
+
+        for (int impl=0; impl < TruePeakDetector::IMPL_COUNT; ++impl)
+        {
+            TruePeakDetector detector;
+            detector.init(kChannels);
+
+            if (! detector.setImpl(TruePeakDetector::Impl(impl)))
+            {
+                std::printf(" %18s", "n/a");
+                continue;
+            }
+
+            const double start = now_ns();
+
+            for (uint64_t i=0; i < iterations; ++i)
+                detector.process(buffers, frames, peaks);
+
+            const double perChannel = (now_ns() - start) / double(iterations * kChannels);
+
+            std::printf(" %10.0f %6.3f%%", perChannel, perChannel / cycleNs * 100.0);
+        }
+
+        std::printf("\n");
+    }
+
+    for (uint32_t c=0; c < kChannels; ++c)
+        delete[] buffers[c];
+
+    return 0;
+}
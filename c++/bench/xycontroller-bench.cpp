@@ -0,0 +1,161 @@
+/*
+ * xycontroller process callback benchmark
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "synthetic_jack.hpp"
+#include "../xycontroller/midiengine.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// -------------------------------
+// Runs MidiEngine::process(), the whole of xycontroller's process callback,
+// with the same events arriving on midi_in every cycle and the same number
+// queued for midi_out by the simulated GUI, which also drains what came in.
+// The GUI side is part of the timing. Each result is the best of kRepeats.
+
+static const uint64_t kCyclesPerRun = 1 << 14;
+static const uint32_t kRepeats      = 5;
+static const uint32_t kMaxFrames    = 4096;
+
+static double now_ns()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool bench_engine(const uint32_t events, const uint32_t frames, double& perCycle)
+{
+    synthetic_jack_init(kMaxFrames);
+
+    MidiEngine engine;
+
+    if (! engine.registerPorts(synthetic_jack_get_client()))
+        return false;
+
+    // alternating note-on/off and CC on all 16 channels
+    jack_midi_data_t* const data = new jack_midi_data_t[events*3 + 3];
+    MidiMessage* const messages  = new MidiMessage[events + 1];
+
+    for (uint32_t i=0; i < events; ++i)
+    {
+        const uint8_t status = (i % 3 == 0) ? 0xB0 : ((i % 3 == 1) ? 0x90 : 0x80);
+
+        data[i*3]   = status | (i & 0x0F);
+        data[i*3+1] = i % 128;
+        data[i*3+2] = (i * 7) % 128;
+
+        messages[i].size    = 3;
+        messages[i].data[0] = data[i*3];
+        messages[i].data[1] = data[i*3+1];
+        messages[i].data[2] = data[i*3+2];
+    }
+
+    jack_port_t* const midiIn  = synthetic_jack_get_port("midi_in");
+    jack_port_t* const midiOut = synthetic_jack_get_port("midi_out");
+
+    const bool ok = synthetic_jack_set_midi_input(midiIn, data, events, frames);
+
+    RingBuffer<MidiMessage>& input(engine.getInput());
+    RingBuffer<MidiMessage>& output(engine.getOutput());
+
+    for (uint32_t r=0; ok && r < kRepeats; ++r)
+    {
+        const double start = now_ns();
+
+        for (uint64_t i=0; i < kCyclesPerRun; ++i)
+        {
+            output.write(messages, events);
+            engine.process(frames);
+            input.skip();
+        }
+
+        const double cycle = (now_ns() - start) / double(kCyclesPerRun);
+
+        if (r == 0 || cycle < perCycle)
+            perCycle = cycle;
+    }
+
+    // everything must have gone through, or the numbers are for less work
+    const bool complete = ok && synthetic_jack_get_midi_output_count(midiOut) == events;
+
+    delete[] data;
+    delete[] messages;
+
+    return complete;
+}
+
+static uint32_t get_arg(const int argc, char* argv[], const char* const name)
+{
+    for (int i=1; i+1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], name) == 0)
+            return uint32_t(std::atoi(argv[i+1]));
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // '-frames N' and '-events N' run a single case instead of the sweep
+    const uint32_t onlyFrames = get_arg(argc, argv, "-frames");
+    const uint32_t onlyEvents = get_arg(argc, argv, "-events");
+
+    if (onlyFrames > kMaxFrames || onlyEvents > MidiEngine::kQueueSize)
+    {
+        std::fprintf(stderr, "xycontroller: at most %u frames and %u events per cycle\n", kMaxFrames, MidiEngine::kQueueSize);
+        return 1;
+    }
+
+    static const uint32_t kEventSweep[] = { 0, 4, 32, 256, 512 };
+
+    std::printf("xycontroller: process callback cost, events per cycle in each direction\n");
+    std::printf("%6s %6s %12s %10s %14s\n", "frames", "events", "ns/cycle", "ns/frame", "events/s");
+
+    for (uint32_t frames=64; frames <= 2048; frames *= 4)
+    {
+        if (onlyFrames > 0)
+            frames = onlyFrames;
+
+        for (uint32_t e=0; e < 5; ++e)
+        {
+            const uint32_t events = (onlyEvents > 0) ? onlyEvents : kEventSweep[e];
+            double perCycle = 0.0;
+
+            if (! bench_engine(events, frames, perCycle))
+            {
+                std::fprintf(stderr, "xycontroller: %u events per cycle did not all go through\n", events);
+                return 1;
+            }
+
+            // in and out both count, per second of process time
+            const double rate = (events > 0) ? double(events * 2) / perCycle * 1e9 : 0.0;
+
+            std::printf("%6u %6u %12.1f %10.3f %14.0f\n", frames, events, perCycle, perCycle / double(frames), rate);
+
+            if (onlyEvents > 0)
+                break;
+        }
+
+        if (onlyFrames > 0)
+            break;
+    }
+
+    synthetic_jack_init(0);
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Radix-2 real FFT
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "fft.hpp"
+
+#include <cmath>
+
+RealFFT::RealFFT()
+    : fSize(0),
+      fHalf(0),
+      fBitReverse(nullptr),
+      fTwiddles(nullptr),
+      fSplit(nullptr),
+      fWork(nullptr) {}
+
+RealFFT::~RealFFT()
+{
+    delete[] fBitReverse;
+    delete[] fTwiddles;
+    delete[] fSplit;
+    delete[] fWork;
+}
+
+bool RealFFT::init(const uint32_t size)
+{
+    if (size < 4 || (size & (size-1)) != 0)
+        return false;
+
+    delete[] fBitReverse;
+    delete[] fTwiddles;
+    delete[] fSplit;
+    delete[] fWork;
+
+    fSize = size;
+    fHalf = size/2;
+
+    fBitReverse = new uint32_t[fHalf];
+    fTwiddles   = new float[fHalf];
+    fSplit      = new float[fHalf*2];
+    fWork       = new float[fHalf*2];
+
+    uint32_t bits = 0;
+
+    while ((1U << bits) < fHalf)
+        ++bits;
+
+    for (uint32_t i=0; i < fHalf; ++i)
+    {
+        uint32_t reversed = 0;
+
+        for (uint32_t b=0; b < bits; ++b)
+            reversed |= ((i >> b) & 1) << (bits-1-b);
+
+        fBitReverse[i] = reversed;
+    }
+
+    for (uint32_t i=0; i < fHalf/2; ++i)
+    {
+        const double phase = -2.0 * M_PI * double(i) / double(fHalf);
+        fTwiddles[i*2]   = float(std::cos(phase));
+        fTwiddles[i*2+1] = float(std::sin(phase));
+    }
+
+    for (uint32_t i=0; i < fHalf; ++i)
+    {
+        const double phase = -2.0 * M_PI * double(i) / double(fSize);
+        fSplit[i*2]   = float(std::cos(phase));
+        fSplit[i*2+1] = float(std::sin(phase));
+    }
+
+    return true;
+}
+
+uint32_t RealFFT::getSize() const
+{
+    return fSize;
+}
+
+void RealFFT::forward(const float* const input, float* const output)
+{
+    const uint32_t half = fHalf;
+    float* const work = fWork;
+
+    // even samples as real, odd as imaginary, in bit-reversed order
+    for (uint32_t i=0; i < half; ++i)
+    {
+        const uint32_t j = fBitReverse[i];
+        work[j*2]   = input[i*2];
+        work[j*2+1] = input[i*2+1];
+    }
+
+    // iterative radix-2 butterflies
+    for (uint32_t len=2, stride=half/2; len <= half; len <<= 1, stride >>= 1)
+    {
+        const uint32_t step = len/2;
+
+        for (uint32_t start=0; start < half; start += len)
+        {
+            float* const a = work + start*2;
+            float* const b = a + step*2;
+
+            for (uint32_t k=0; k < step; ++k)
+            {
+                const float wr = fTwiddles[k*stride*2];
+                const float wi = fTwiddles[k*stride*2+1];
+
+                const float br = b[k*2]*wr - b[k*2+1]*wi;
+                const float bi = b[k*2]*wi + b[k*2+1]*wr;
+
+                b[k*2]   = a[k*2]   - br;
+                b[k*2+1] = a[k*2+1] - bi;
+                a[k*2]   += br;
+                a[k*2+1] += bi;
+            }
+        }
+    }
+
+    // split into the spectrum of the real input:
+    // X[k] = (Z[k] + conj(Z[N/2-k]))/2 - i*W^k * (Z[k] - conj(Z[N/2-k]))/2
+    output[0]        = work[0] + work[1];
+    output[1]        = 0.0f;
+    output[half*2]   = work[0] - work[1];
+    output[half*2+1] = 0.0f;
+
+    for (uint32_t k=1; k < half; ++k)
+    {
+        const uint32_t m = half - k;
+
+        const float zr = work[k*2], zi = work[k*2+1];
+        const float cr = work[m*2], ci = -work[m*2+1];
+
+        const float er = 0.5f * (zr + cr);
+        const float ei = 0.5f * (zi + ci);
+        const float dr = 0.5f * (zr - cr);
+        const float di = 0.5f * (zi - ci);
+
+        // -i * (dr + i*di) = di - i*dr, then times the twiddle
+        const float tr = di, ti = -dr;
+        const float wr = fSplit[k*2], wi = fSplit[k*2+1];
+
+        output[k*2]   = er + tr*wr - ti*wi;
+        output[k*2+1] = ei + tr*wi + ti*wr;
+    }
+}
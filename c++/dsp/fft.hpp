@@ -0,0 +1,55 @@
+/*
+ * Radix-2 real FFT
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __FFT_HPP__
+#define __FFT_HPP__
+
+#include <stdint.h>
+
+// -------------------------------
+// Forward transform of 'size' real samples (a power of 2, at least 4).
+// Runs a complex FFT of size/2 points over the even/odd samples packed as
+// real/imaginary parts, then splits the result into the real spectrum.
+// Twiddles and the bit-reversal table are computed once in init(), so
+// forward() does no allocation and no trigonometry.
+
+class RealFFT
+{
+public:
+    RealFFT();
+    ~RealFFT();
+
+    // not realtime safe
+    bool init(uint32_t size);
+
+    uint32_t getSize() const;
+
+    // 'output' gets size/2+1 complex values, interleaved as re, im
+    // (the imaginary parts of the first and last one are always 0)
+    void forward(const float* input, float* output);
+
+private:
+    uint32_t fSize;
+    uint32_t fHalf;
+
+    uint32_t* fBitReverse; // fHalf entries
+    float*    fTwiddles;   // fHalf/2 complex, for the complex FFT
+    float*    fSplit;      // fHalf complex, for the real split
+    float*    fWork;       // fHalf complex
+};
+
+#endif // __FFT_HPP__
@@ -0,0 +1,211 @@
+/*
+ * Min/max decimation pyramid, for level history views
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "levelpyramid.hpp"
+
+static void merge_record(LevelRecord& target, const LevelRecord& record)
+{
+    if (record.min < target.min)
+        target.min = record.min;
+    if (record.max > target.max)
+        target.max = record.max;
+}
+
+// -------------------------------
+
+LevelPyramid::LevelPyramid()
+    : fLevelCount(0)
+{
+    for (uint32_t i=0; i < kMaxLevels; ++i)
+    {
+        fLevels[i].records  = nullptr;
+        fLevels[i].capacity = 0;
+    }
+
+    clear();
+}
+
+LevelPyramid::~LevelPyramid()
+{
+    for (uint32_t i=0; i < kMaxLevels; ++i)
+        delete[] fLevels[i].records;
+}
+
+void LevelPyramid::init(const uint32_t capacity)
+{
+    for (uint32_t i=0; i < kMaxLevels; ++i)
+    {
+        delete[] fLevels[i].records;
+        fLevels[i].records  = nullptr;
+        fLevels[i].capacity = 0;
+    }
+
+    fLevelCount = 0;
+
+    // level 0 keeps everything, the others keep one extra record so their
+    // oldest one still overlaps the oldest record of level 0
+    for (uint32_t size = (capacity > 0) ? capacity : 1; fLevelCount < kMaxLevels; size /= kFactor)
+    {
+        Level& level(fLevels[fLevelCount]);
+        level.capacity = (fLevelCount == 0) ? size : size + 2;
+        level.records  = new LevelRecord[level.capacity];
+        ++fLevelCount;
+
+        if (size < kFactor)
+            break;
+    }
+
+    clear();
+}
+
+void LevelPyramid::clear()
+{
+    for (uint32_t i=0; i < kMaxLevels; ++i)
+    {
+        fLevels[i].count = 0;
+        fLevels[i].pendingSquares = 0.0;
+        fLevels[i].pendingCount   = 0;
+    }
+}
+
+void LevelPyramid::add(const LevelRecord& record)
+{
+    if (fLevelCount == 0)
+        return;
+
+    LevelRecord carry(record);
+
+    for (uint32_t i=0; i < fLevelCount; ++i)
+    {
+        Level& level(fLevels[i]);
+
+        if (i > 0)
+        {
+            if (level.pendingCount == 0)
+                level.pending = carry;
+            else
+                merge_record(level.pending, carry);
+
+            level.pendingSquares += carry.meanSquare;
+
+            if (++level.pendingCount < kFactor)
+                return;
+
+            carry = level.pending;
+            carry.meanSquare = float(level.pendingSquares / kFactor);
+
+            level.pendingSquares = 0.0;
+            level.pendingCount   = 0;
+        }
+
+        level.records[level.count % level.capacity] = carry;
+        ++level.count;
+    }
+}
+
+uint32_t LevelPyramid::getCapacity() const
+{
+    return (fLevelCount > 0) ? fLevels[0].capacity : 0;
+}
+
+uint64_t LevelPyramid::getCount() const
+{
+    return fLevels[0].count;
+}
+
+bool LevelPyramid::getRange(uint64_t first, const uint64_t count, LevelRecord& result) const
+{
+    if (fLevelCount == 0 || count == 0)
+        return false;
+
+    const Level& base(fLevels[0]);
+    const uint64_t oldest = (base.count > base.capacity) ? base.count - base.capacity : 0;
+    uint64_t end = first + count;
+
+    if (first < oldest)
+        first = oldest;
+    if (end > base.count)
+        end = base.count;
+    if (first >= end)
+        return false;
+
+    // coarsest level whose records are not longer than the range
+    uint32_t level = 0;
+    uint64_t span  = kFactor;
+
+    while (level+1 < fLevelCount && span <= end - first)
+    {
+        ++level;
+        span *= kFactor;
+    }
+
+    Merge merge;
+    merge.squares = 0.0;
+    merge.weight  = 0.0;
+
+    mergeLevel(level, first, end, merge);
+
+    if (merge.weight == 0.0)
+        return false;
+
+    result = merge.record;
+    result.meanSquare = float(merge.squares / merge.weight);
+    return true;
+}
+
+void LevelPyramid::mergeLevel(const uint32_t index, const uint64_t first, const uint64_t end, Merge& merge) const
+{
+    const Level& level(fLevels[index]);
+
+    uint64_t span = 1;
+
+    for (uint32_t i=0; i < index; ++i)
+        span *= kFactor;
+
+    const uint64_t oldest = (level.count > level.capacity) ? level.count - level.capacity : 0;
+    uint64_t recordFirst  = first / span;
+    uint64_t recordEnd    = (end + span - 1) / span;
+
+    if (recordFirst < oldest)
+        recordFirst = oldest;
+    if (recordEnd > level.count)
+        recordEnd = level.count;
+
+    uint64_t covered = first;
+
+    if (recordFirst < recordEnd)
+    {
+        for (uint64_t i=recordFirst; i < recordEnd; ++i)
+        {
+            const LevelRecord& record(level.records[i % level.capacity]);
+
+            if (merge.weight == 0.0)
+                merge.record = record;
+            else
+                merge_record(merge.record, record);
+
+            merge.squares += double(record.meanSquare) * double(span);
+            merge.weight  += double(span);
+        }
+
+        covered = recordEnd * span;
+    }
+
+    // the newest records of this level are not complete yet, finish from below
+    if (covered < end && index > 0)
+        mergeLevel(index-1, covered > first ? covered : first, end, merge);
+}
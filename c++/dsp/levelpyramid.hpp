@@ -0,0 +1,89 @@
+/*
+ * Min/max decimation pyramid, for level history views
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __LEVELPYRAMID_HPP__
+#define __LEVELPYRAMID_HPP__
+
+#include <stdint.h>
+
+// -------------------------------
+// One record per JACK cycle, the only thing the JACK thread hands over.
+
+struct LevelRecord {
+    float min;
+    float max;
+    float meanSquare;
+};
+
+// -------------------------------
+// GUI side: keeps the last 'capacity' records plus coarser copies of them,
+// each level merging kFactor records of the level below into one.
+// Level 0 is a ring of 'capacity' records, level n holds capacity/kFactor^n,
+// so memory is bounded by capacity * kFactor/(kFactor-1) records.
+// getRange() reads from the coarsest level that still fits the range, so
+// it costs the same for a range of 10 records or of 10 million, and a view
+// calling it once per pixel column draws in time proportional to its width.
+
+class LevelPyramid
+{
+public:
+    static const uint32_t kFactor = 4;
+    static const uint32_t kMaxLevels = 16;
+
+    LevelPyramid();
+    ~LevelPyramid();
+
+    // not realtime safe
+    void init(uint32_t capacity);
+    void clear();
+
+    void add(const LevelRecord& record);
+
+    uint32_t getCapacity() const;
+
+    // records added since clear(), the newest one is getCount()-1
+    uint64_t getCount() const;
+
+    // merge of records [first, first+count), clipped to what is still kept
+    // and rounded outwards to whole records of the level it is read from;
+    // returns false if nothing of it is kept
+    bool getRange(uint64_t first, uint64_t count, LevelRecord& result) const;
+
+private:
+    struct Level {
+        LevelRecord* records;
+        uint32_t     capacity;
+        uint64_t     count;   // records completed at this level
+        // merge of the records below not completed yet
+        LevelRecord  pending;
+        double       pendingSquares;
+        uint32_t     pendingCount;
+    };
+
+    uint32_t fLevelCount;
+    Level    fLevels[kMaxLevels];
+
+    struct Merge {
+        LevelRecord record;
+        double squares;
+        double weight;
+    };
+
+    void mergeLevel(uint32_t level, uint64_t first, uint64_t end, Merge& merge) const;
+};
+
+#endif // __LEVELPYRAMID_HPP__
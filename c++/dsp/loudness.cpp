@@ -0,0 +1,414 @@
+/*
+ * EBU R128 / ITU-R BS.1770 loudness metering
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "loudness.hpp"
+
+#include <cmath>
+#include <cstring>
+
+// keeps the filters out of denormals on silence, removed again by the highpass
+static const float kAntiDenormal = 1e-18f;
+
+static const double kAbsoluteGate = -70.0;
+static const double kRelativeGateIntegrated = -10.0;
+static const double kRelativeGateRange = -20.0;
+
+static inline
+double power_to_lufs(const double meanSquare)
+{
+    return -0.691 + 10.0 * std::log10(meanSquare);
+}
+
+static inline
+double lufs_to_power(const double loudness)
+{
+    return std::pow(10.0, (loudness + 0.691) / 10.0);
+}
+
+// -------------------------------
+// LoudnessFilterBank
+
+LoudnessFilterBank::LoudnessFilterBank()
+    : fChannels(0),
+      fStride(0),
+      fBlockFrames(0),
+      fBlockPos(0),
+      fB0(1.0f), fB1(0.0f), fB2(0.0f), fA1(0.0f), fA2(0.0f),
+      fHpA1(0.0f), fHpA2(0.0f),
+      fScratch(nullptr),
+      fWeights(nullptr),
+      fZ1(nullptr),
+      fZ2(nullptr),
+      fHpZ1(nullptr),
+      fHpZ2(nullptr),
+      fSums(nullptr) {}
+
+LoudnessFilterBank::~LoudnessFilterBank()
+{
+    delete[] fScratch;
+    delete[] fWeights;
+    delete[] fZ1;
+    delete[] fZ2;
+    delete[] fHpZ1;
+    delete[] fHpZ2;
+    delete[] fSums;
+}
+
+void LoudnessFilterBank::init(const double sampleRate, const uint32_t channels)
+{
+    // BS.1770 stage 1, high shelf
+    {
+        const double f0 = 1681.974450955533;
+        const double G  = 3.999843853973347;
+        const double Q  = 0.7071752369554196;
+
+        const double K  = std::tan(M_PI * f0 / sampleRate);
+        const double Vh = std::pow(10.0, G / 20.0);
+        const double Vb = std::pow(Vh, 0.4996667741545416);
+        const double a0 = 1.0 + K / Q + K * K;
+
+        fB0 = (Vh + Vb * K / Q + K * K) / a0;
+        fB1 = 2.0 * (K * K - Vh) / a0;
+        fB2 = (Vh - Vb * K / Q + K * K) / a0;
+        fA1 = 2.0 * (K * K - 1.0) / a0;
+        fA2 = (1.0 - K / Q + K * K) / a0;
+    }
+
+    // BS.1770 stage 2, RLB highpass
+    {
+        const double f0 = 38.13547087602444;
+        const double Q  = 0.5003270373238773;
+
+        const double K  = std::tan(M_PI * f0 / sampleRate);
+        const double a0 = 1.0 + K / Q + K * K;
+
+        fHpA1 = 2.0 * (K * K - 1.0) / a0;
+        fHpA2 = (1.0 - K / Q + K * K) / a0;
+    }
+
+    fChannels    = channels;
+    fStride      = (channels + 7) & ~7U;
+    fBlockFrames = uint32_t(sampleRate / 10.0 + 0.5);
+    fBlockPos    = 0;
+
+    delete[] fScratch;
+    delete[] fWeights;
+    delete[] fZ1;
+    delete[] fZ2;
+    delete[] fHpZ1;
+    delete[] fHpZ2;
+    delete[] fSums;
+
+    fScratch = new float[kChunkFrames * fStride];
+    fWeights = new float[fStride];
+    fZ1      = new float[fStride];
+    fZ2      = new float[fStride];
+    fHpZ1    = new float[fStride];
+    fHpZ2    = new float[fStride];
+    fSums    = new float[fStride];
+
+    std::memset(fScratch, 0, sizeof(float)*kChunkFrames*fStride);
+    std::memset(fZ1,      0, sizeof(float)*fStride);
+    std::memset(fZ2,      0, sizeof(float)*fStride);
+    std::memset(fHpZ1,    0, sizeof(float)*fStride);
+    std::memset(fHpZ2,    0, sizeof(float)*fStride);
+    std::memset(fSums,    0, sizeof(float)*fStride);
+
+    for (uint32_t i=0; i < fStride; ++i)
+        fWeights[i] = (i < channels) ? 1.0f : 0.0f;
+
+    // BS.1770 5.1 layout (L, R, C, LFE, Ls, Rs)
+    if (channels == 6)
+    {
+        fWeights[3] = 0.0f;
+        fWeights[4] = 1.41f;
+        fWeights[5] = 1.41f;
+    }
+}
+
+void LoudnessFilterBank::setChannelWeight(const uint32_t channel, const float weight)
+{
+    if (channel < fChannels)
+        fWeights[channel] = weight;
+}
+
+uint32_t LoudnessFilterBank::getChannels() const
+{
+    return fChannels;
+}
+
+uint32_t LoudnessFilterBank::process(const float* const* const buffers, const uint32_t frames, float* const blocks, const uint32_t maxBlocks)
+{
+    return process(buffers, nullptr, fChannels, frames, blocks, maxBlocks);
+}
+
+uint32_t LoudnessFilterBank::process(const float* const* const buffers, const uint32_t* const channels, const uint32_t count,
+                                     const uint32_t frames, float* const blocks, const uint32_t maxBlocks)
+{
+    const uint32_t stride = fStride;
+    const float b0 = fB0, b1 = fB1, b2 = fB2, a1 = fA1, a2 = fA2;
+    const float hpA1 = fHpA1, hpA2 = fHpA2;
+
+    float* const z1   = fZ1;
+    float* const z2   = fZ2;
+    float* const hpZ1 = fHpZ1;
+    float* const hpZ2 = fHpZ2;
+    float* const sums = fSums;
+
+    uint32_t blockCount = 0;
+
+    for (uint32_t offset = 0; offset < frames;)
+    {
+        uint32_t chunk = frames - offset;
+
+        if (chunk > kChunkFrames)
+            chunk = kChunkFrames;
+        if (chunk > fBlockFrames - fBlockPos)
+            chunk = fBlockFrames - fBlockPos;
+
+        // channels without a buffer are silent
+        if (count < fChannels)
+        {
+            for (uint32_t i=0; i < chunk*stride; ++i)
+                fScratch[i] = kAntiDenormal;
+        }
+
+        // transpose into frame-major order, so each frame is one contiguous vector of channels
+        for (uint32_t k=0; k < count; ++k)
+        {
+            const uint32_t c = (channels != nullptr) ? channels[k] : k;
+            const float* const in = buffers[k] + offset;
+
+            for (uint32_t i=0; i < chunk; ++i)
+                fScratch[i*stride + c] = in[i] + kAntiDenormal;
+        }
+
+        for (uint32_t i=0; i < chunk; ++i)
+        {
+            const float* const x = fScratch + i*stride;
+
+            for (uint32_t c=0; c < stride; ++c)
+            {
+                const float y1 = b0 * x[c] + z1[c];
+                z1[c] = b1 * x[c] - a1 * y1 + z2[c];
+                z2[c] = b2 * x[c] - a2 * y1;
+
+                const float y2 = y1 + hpZ1[c];
+                hpZ1[c] = -2.0f * y1 - hpA1 * y2 + hpZ2[c];
+                hpZ2[c] = y1 - hpA2 * y2;
+
+                sums[c] += y2 * y2;
+            }
+        }
+
+        offset    += chunk;
+        fBlockPos += chunk;
+
+        if (fBlockPos == fBlockFrames)
+        {
+            float power = 0.0f;
+
+            for (uint32_t c=0; c < stride; ++c)
+            {
+                power  += fWeights[c] * sums[c];
+                sums[c] = 0.0f;
+            }
+
+            if (blockCount < maxBlocks)
+                blocks[blockCount++] = power / float(fBlockFrames);
+
+            fBlockPos = 0;
+        }
+    }
+
+    return blockCount;
+}
+
+// -------------------------------
+// LoudnessMeter
+
+const float LoudnessMeter::kSilence = -HUGE_VALF;
+
+LoudnessMeter::LoudnessMeter()
+{
+    reset();
+}
+
+void LoudnessMeter::reset()
+{
+    for (int i=0; i < kHistorySize; ++i)
+        fHistory[i] = 0.0f;
+
+    fHistoryPos = 0;
+    fBlocks     = 0;
+
+    fIntegrated.clear();
+    fShortTerm.clear();
+}
+
+void LoudnessMeter::addBlock(const float meanSquare)
+{
+    fHistory[fHistoryPos] = meanSquare;
+    fHistoryPos = (fHistoryPos + 1) % kHistorySize;
+    ++fBlocks;
+
+    // 400 ms gating blocks, overlapping by 75%
+    if (fBlocks >= 4)
+    {
+        const double power = getMeanSquare(4);
+        fIntegrated.add(power_to_lufs(power), power);
+    }
+
+    // 3 s short-term blocks, at the same 10 Hz rate
+    if (fBlocks >= kHistorySize)
+    {
+        const double power = getMeanSquare(kHistorySize);
+        fShortTerm.add(power_to_lufs(power), power);
+    }
+}
+
+float LoudnessMeter::getMomentary() const
+{
+    if (fBlocks < 4)
+        return kSilence;
+
+    return power_to_lufs(getMeanSquare(4));
+}
+
+float LoudnessMeter::getShortTerm() const
+{
+    if (fBlocks < kHistorySize)
+        return kSilence;
+
+    return power_to_lufs(getMeanSquare(kHistorySize));
+}
+
+float LoudnessMeter::getIntegrated() const
+{
+    if (fIntegrated.total == 0)
+        return kSilence;
+
+    const double relativeGate = power_to_lufs(fIntegrated.totalPower / fIntegrated.total) + kRelativeGateIntegrated;
+    const double power = fIntegrated.gatedPower(relativeGate);
+
+    return (power > 0.0) ? power_to_lufs(power) : kSilence;
+}
+
+float LoudnessMeter::getRange() const
+{
+    if (fShortTerm.total == 0)
+        return 0.0f;
+
+    const double relativeGate = power_to_lufs(fShortTerm.totalPower / fShortTerm.total) + kRelativeGateRange;
+
+    int first = int((relativeGate - kAbsoluteGate) * 10.0);
+
+    if (first < 0)
+        first = 0;
+
+    uint32_t count = 0;
+
+    for (int i=first; i < kBinCount; ++i)
+        count += fShortTerm.count[i];
+
+    if (count == 0)
+        return 0.0f;
+
+    // 10th and 95th percentiles of the gated short-term distribution
+    const uint32_t lowTarget  = uint32_t(double(count) * 0.10);
+    const uint32_t highTarget = uint32_t(double(count) * 0.95);
+
+    int low = first, high = first;
+    uint32_t seen = 0;
+
+    for (int i=first; i < kBinCount; ++i)
+    {
+        if (fShortTerm.count[i] == 0)
+            continue;
+
+        if (seen <= lowTarget)
+            low = i;
+
+        seen += fShortTerm.count[i];
+
+        if (seen > highTarget)
+        {
+            high = i;
+            break;
+        }
+
+        high = i;
+    }
+
+    return float(high - low) / 10.0f;
+}
+
+double LoudnessMeter::getMeanSquare(const int blocks) const
+{
+    double sum = 0.0;
+
+    for (int i=1; i <= blocks; ++i)
+        sum += fHistory[(fHistoryPos - i + kHistorySize) % kHistorySize];
+
+    return sum / blocks;
+}
+
+// -------------------------------
+// LoudnessMeter::Histogram
+
+void LoudnessMeter::Histogram::clear()
+{
+    std::memset(count, 0, sizeof(count));
+    std::memset(power, 0, sizeof(power));
+    total      = 0;
+    totalPower = 0.0;
+}
+
+void LoudnessMeter::Histogram::add(const double loudness, const double meanSquare)
+{
+    if (! (loudness > kAbsoluteGate))
+        return;
+
+    int bin = int((loudness - kAbsoluteGate) * 10.0);
+
+    if (bin >= kBinCount)
+        bin = kBinCount - 1;
+
+    count[bin] += 1;
+    power[bin] += meanSquare;
+    total      += 1;
+    totalPower += meanSquare;
+}
+
+double LoudnessMeter::Histogram::gatedPower(const double gate) const
+{
+    int first = int((gate - kAbsoluteGate) * 10.0);
+
+    if (first < 0)
+        first = 0;
+
+    uint32_t gatedCount = 0;
+    double   gatedPower = 0.0;
+
+    for (int i=first; i < kBinCount; ++i)
+    {
+        gatedCount += count[i];
+        gatedPower += power[i];
+    }
+
+    return (gatedCount > 0) ? gatedPower / gatedCount : 0.0;
+}
@@ -0,0 +1,117 @@
+/*
+ * EBU R128 / ITU-R BS.1770 loudness metering
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __LOUDNESS_HPP__
+#define __LOUDNESS_HPP__
+
+#include <stdint.h>
+
+// -------------------------------
+// Realtime side: K-weighting filter bank and 100 ms block power.
+// Filter state is kept per channel in plain arrays and every frame runs the
+// two biquads across all channels at once, so the inner loop vectorizes.
+// Only one value per 100 ms block (the channel-weighted mean square) leaves
+// the JACK thread, everything else happens in LoudnessMeter.
+
+class LoudnessFilterBank
+{
+public:
+    LoudnessFilterBank();
+    ~LoudnessFilterBank();
+
+    // not realtime safe
+    void init(double sampleRate, uint32_t channels);
+    void setChannelWeight(uint32_t channel, float weight);
+
+    uint32_t getChannels() const;
+
+    // returns the number of completed 100 ms blocks written into 'blocks'
+    // (at most 'maxBlocks', the rest is dropped)
+    uint32_t process(const float* const* buffers, uint32_t frames, float* blocks, uint32_t maxBlocks);
+
+    // same with only 'count' channels given, buffers[k] belongs to channel channels[k]
+    // and the others are taken as silence
+    uint32_t process(const float* const* buffers, const uint32_t* channels, uint32_t count,
+                     uint32_t frames, float* blocks, uint32_t maxBlocks);
+
+private:
+    static const uint32_t kChunkFrames = 32;
+
+    uint32_t fChannels;
+    uint32_t fStride;
+    uint32_t fBlockFrames;
+    uint32_t fBlockPos;
+
+    // shelf, then highpass (b0 is 1.0, b1 -2.0 and b2 1.0)
+    float fB0, fB1, fB2, fA1, fA2;
+    float fHpA1, fHpA2;
+
+    float* fScratch;
+    float* fWeights;
+    float* fZ1;
+    float* fZ2;
+    float* fHpZ1;
+    float* fHpZ2;
+    float* fSums;
+};
+
+// -------------------------------
+// GUI side: momentary, short-term, integrated (gated) loudness and range.
+// Gating uses fixed histograms, so adding a block and reading values is
+// constant time however long the measurement runs.
+
+class LoudnessMeter
+{
+public:
+    static const float kSilence; // returned when nothing was measured yet
+
+    LoudnessMeter();
+
+    void reset();
+    void addBlock(float meanSquare);
+
+    float getMomentary() const;  // LUFS, 400 ms
+    float getShortTerm() const;  // LUFS, 3 s
+    float getIntegrated() const; // LUFS, gated since reset()
+    float getRange() const;      // LU
+
+private:
+    static const int kHistorySize = 30; // 3 s of 100 ms blocks
+    static const int kBinCount    = 750; // -70 to +5 LUFS, 0.1 LU each
+
+    float fHistory[kHistorySize];
+    int   fHistoryPos;
+    int   fBlocks;
+
+    struct Histogram {
+        uint32_t count[kBinCount];
+        double   power[kBinCount];
+        uint32_t total;
+        double   totalPower;
+
+        void clear();
+        void add(double loudness, double meanSquare);
+        double gatedPower(double gate) const;
+    };
+
+    Histogram fIntegrated;
+    Histogram fShortTerm;
+
+    double getMeanSquare(int blocks) const;
+};
+
+#endif // __LOUDNESS_HPP__
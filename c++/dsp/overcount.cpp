@@ -0,0 +1,46 @@
+/*
+ * Over (clip) counting
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "overcount.hpp"
+
+#include <cmath>
+
+// -------------------------------
+
+uint32_t overcount_process(const float* const buffer, const uint32_t frames, const float threshold, const uint32_t minLength, uint32_t& run)
+{
+    uint32_t overs = 0;
+    uint32_t count = run;
+
+    for (uint32_t i=0; i < frames; ++i)
+    {
+        const uint32_t hot = (std::fabs(buffer[i]) >= threshold);
+
+        // stops one past minLength, so a long run neither wraps nor counts again
+        count  = (count + (count <= minLength)) * hot;
+        overs += (count == minLength);
+    }
+
+    run = count;
+    return overs;
+}
+
+float overcount_threshold(const float dBFS)
+{
+    // a hair below, so a 0 dBFS threshold catches samples stored as exactly 1.0
+    return std::pow(10.0f, dBFS / 20.0f) * 0.99999f;
+}
@@ -0,0 +1,35 @@
+/*
+ * Over (clip) counting
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __OVERCOUNT_HPP__
+#define __OVERCOUNT_HPP__
+
+#include <stdint.h>
+
+// -------------------------------
+// An over is a run of at least 'minLength' consecutive samples with
+// |x| >= threshold. A run counts once, when it reaches 'minLength', however
+// long it goes on. The current run length carries over between blocks in
+// 'run', which starts at 0. The loop has no data-dependent branches.
+
+// returns the number of overs that completed in this block
+uint32_t overcount_process(const float* buffer, uint32_t frames, float threshold, uint32_t minLength, uint32_t& run);
+
+// threshold as a linear amplitude, 0 dBFS is 1.0
+float overcount_threshold(float dBFS);
+
+#endif // __OVERCOUNT_HPP__
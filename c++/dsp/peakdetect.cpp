@@ -0,0 +1,221 @@
+/*
+ * Peak detection kernels, with runtime CPU dispatch
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "peakdetect.hpp"
+
+#include <cmath>
+
+#if defined(__GNUC__) && (__GNUC__ * 100 + __GNUC_MINOR__) >= 409 && (defined(__x86_64__) || defined(__i386__))
+# define PEAKDETECT_X86
+# include <immintrin.h>
+#endif
+
+// -------------------------------
+// Scalar fallback
+
+static float peakdetect_scalar(const float* const buffer, const uint32_t frames, float peak)
+{
+    for (uint32_t i=0; i < frames; ++i)
+    {
+        const float value = std::fabs(buffer[i]);
+
+        if (value > peak)
+            peak = value;
+    }
+
+    return peak;
+}
+
+#ifdef PEAKDETECT_X86
+
+// -------------------------------
+// SSE2, 8 frames per iteration
+
+__attribute__((target("sse2")))
+static float peakdetect_sse2(const float* const buffer, const uint32_t frames, float peak)
+{
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    __m128 peak1 = _mm_set1_ps(peak);
+    __m128 peak2 = peak1;
+
+    uint32_t i = 0;
+
+    for (; i+8 <= frames; i += 8)
+    {
+        peak1 = _mm_max_ps(peak1, _mm_and_ps(_mm_loadu_ps(buffer+i),   absMask));
+        peak2 = _mm_max_ps(peak2, _mm_and_ps(_mm_loadu_ps(buffer+i+4), absMask));
+    }
+
+    peak1 = _mm_max_ps(peak1, peak2);
+    peak1 = _mm_max_ps(peak1, _mm_shuffle_ps(peak1, peak1, _MM_SHUFFLE(1, 0, 3, 2)));
+    peak1 = _mm_max_ps(peak1, _mm_shuffle_ps(peak1, peak1, _MM_SHUFFLE(2, 3, 0, 1)));
+    peak  = _mm_cvtss_f32(peak1);
+
+    return peakdetect_scalar(buffer+i, frames-i, peak);
+}
+
+// -------------------------------
+// AVX2, 16 frames per iteration
+
+__attribute__((target("avx2")))
+static float peakdetect_avx2(const float* const buffer, const uint32_t frames, float peak)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+    __m256 peak1 = _mm256_set1_ps(peak);
+    __m256 peak2 = peak1;
+
+    uint32_t i = 0;
+
+    for (; i+16 <= frames; i += 16)
+    {
+        peak1 = _mm256_max_ps(peak1, _mm256_and_ps(_mm256_loadu_ps(buffer+i),   absMask));
+        peak2 = _mm256_max_ps(peak2, _mm256_and_ps(_mm256_loadu_ps(buffer+i+8), absMask));
+    }
+
+    peak1 = _mm256_max_ps(peak1, peak2);
+
+    __m128 peak4 = _mm_max_ps(_mm256_castps256_ps128(peak1), _mm256_extractf128_ps(peak1, 1));
+    peak4 = _mm_max_ps(peak4, _mm_shuffle_ps(peak4, peak4, _MM_SHUFFLE(1, 0, 3, 2)));
+    peak4 = _mm_max_ps(peak4, _mm_shuffle_ps(peak4, peak4, _MM_SHUFFLE(2, 3, 0, 1)));
+    peak  = _mm_cvtss_f32(peak4);
+
+    return peakdetect_scalar(buffer+i, frames-i, peak);
+}
+
+// -------------------------------
+// AVX-512, 32 frames per iteration, masked tail
+// (some gcc versions warn about _mm512_undefined_ps() inside their own intrinsics)
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+static float peakdetect_avx512(const float* const buffer, const uint32_t frames, float peak)
+{
+    __m512 peak1 = _mm512_set1_ps(peak);
+    __m512 peak2 = peak1;
+
+    uint32_t i = 0;
+
+    for (; i+32 <= frames; i += 32)
+    {
+        peak1 = _mm512_max_ps(peak1, _mm512_abs_ps(_mm512_loadu_ps(buffer+i)));
+        peak2 = _mm512_max_ps(peak2, _mm512_abs_ps(_mm512_loadu_ps(buffer+i+16)));
+    }
+
+    for (; i < frames; i += 16)
+    {
+        const uint32_t left = frames - i;
+        const __mmask16 mask = (left >= 16) ? 0xffff : __mmask16((1U << left) - 1);
+        peak1 = _mm512_max_ps(peak1, _mm512_abs_ps(_mm512_maskz_loadu_ps(mask, buffer+i)));
+    }
+
+    peak1 = _mm512_max_ps(peak1, peak2);
+
+    const __m256 peak8 = _mm256_max_ps(_mm512_castps512_ps256(peak1),
+                                       _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(peak1), 1)));
+
+    __m128 peak4 = _mm_max_ps(_mm256_castps256_ps128(peak8), _mm256_extractf128_ps(peak8, 1));
+    peak4 = _mm_max_ps(peak4, _mm_shuffle_ps(peak4, peak4, _MM_SHUFFLE(1, 0, 3, 2)));
+    peak4 = _mm_max_ps(peak4, _mm_shuffle_ps(peak4, peak4, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtss_f32(peak4);
+}
+
+#pragma GCC diagnostic pop
+
+#endif // PEAKDETECT_X86
+
+// -------------------------------
+// Dispatch
+
+static PeakDetectImpl gPeakDetectImpl = PEAK_DETECT_SCALAR;
+static PeakDetectFunc gPeakDetectFunc = peakdetect_scalar;
+
+static const struct PeakDetectInit {
+    PeakDetectInit() {
+        for (int i=PEAK_DETECT_COUNT-1; i >= 0; --i)
+        {
+            if (PeakDetectFunc func = peakdetect_get_func(PeakDetectImpl(i)))
+            {
+                gPeakDetectImpl = PeakDetectImpl(i);
+                gPeakDetectFunc = func;
+                break;
+            }
+        }
+    }
+} _peakDetectInit;
+
+float peakdetect_abs_max(const float* const buffer, const uint32_t frames, const float peak)
+{
+    return gPeakDetectFunc(buffer, frames, peak);
+}
+
+void peakdetect_abs_max_multi(const float* const* const buffers, const uint32_t channels, const uint32_t frames, float* const peaks)
+{
+    const PeakDetectFunc func = gPeakDetectFunc;
+
+    for (uint32_t i=0; i < channels; ++i)
+        peaks[i] = func(buffers[i], frames, 0.0f);
+}
+
+PeakDetectImpl peakdetect_get_impl()
+{
+    return gPeakDetectImpl;
+}
+
+const char* peakdetect_get_impl_name(const PeakDetectImpl impl)
+{
+    switch (impl)
+    {
+    case PEAK_DETECT_SCALAR:
+        return "scalar";
+    case PEAK_DETECT_SSE2:
+        return "sse2";
+    case PEAK_DETECT_AVX2:
+        return "avx2";
+    case PEAK_DETECT_AVX512:
+        return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
+PeakDetectFunc peakdetect_get_func(const PeakDetectImpl impl)
+{
+    switch (impl)
+    {
+    case PEAK_DETECT_SCALAR:
+        return peakdetect_scalar;
+#ifdef PEAKDETECT_X86
+    case PEAK_DETECT_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2") ? peakdetect_sse2 : nullptr;
+    case PEAK_DETECT_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? peakdetect_avx2 : nullptr;
+    case PEAK_DETECT_AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") ? peakdetect_avx512 : nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
@@ -0,0 +1,50 @@
+/*
+ * Peak detection kernels, with runtime CPU dispatch
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __PEAKDETECT_HPP__
+#define __PEAKDETECT_HPP__
+
+#include <stdint.h>
+
+// -------------------------------
+// Returns max(peak, |buffer[i]|) over the whole buffer.
+// The block peak is kept in registers, callers publish it once per cycle.
+
+typedef float (*PeakDetectFunc)(const float* buffer, uint32_t frames, float peak);
+
+enum PeakDetectImpl {
+    PEAK_DETECT_SCALAR = 0,
+    PEAK_DETECT_SSE2   = 1,
+    PEAK_DETECT_AVX2   = 2,
+    PEAK_DETECT_AVX512 = 3,
+    PEAK_DETECT_COUNT  = 4
+};
+
+// best implementation for the running CPU, picked once at startup
+float peakdetect_abs_max(const float* buffer, uint32_t frames, float peak);
+
+// same as above for a set of channels in one pass, peaks[i] = max |buffers[i][j]|
+void peakdetect_abs_max_multi(const float* const* buffers, uint32_t channels, uint32_t frames, float* peaks);
+
+// implementation in use by peakdetect_abs_max()
+PeakDetectImpl peakdetect_get_impl();
+const char*    peakdetect_get_impl_name(PeakDetectImpl impl);
+
+// a specific implementation, or null if the CPU (or build) does not support it
+PeakDetectFunc peakdetect_get_func(PeakDetectImpl impl);
+
+#endif // __PEAKDETECT_HPP__
@@ -0,0 +1,221 @@
+/*
+ * Spectrum analyzer, overlapped FFT with logarithmic bands
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "spectrum.hpp"
+
+#include <cmath>
+#include <cstring>
+
+const float SpectrumAnalyzer::kFloor = -120.0f;
+
+// weight of the previous frame when smoothing band power over time
+static const float kTimeSmoothing = 0.6f;
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : fSampleRate(48000.0),
+      fSize(0),
+      fFill(0),
+      fBands(0),
+      fInput(nullptr),
+      fWindowed(nullptr),
+      fWindow(nullptr),
+      fSpectrum(nullptr),
+      fBandFirst(nullptr),
+      fBandEnd(nullptr),
+      fBandFrequency(nullptr),
+      fBandPower(nullptr),
+      fBandLevel(nullptr) {}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    delete[] fInput;
+    delete[] fWindowed;
+    delete[] fWindow;
+    delete[] fSpectrum;
+    delete[] fBandFirst;
+    delete[] fBandEnd;
+    delete[] fBandFrequency;
+    delete[] fBandPower;
+    delete[] fBandLevel;
+}
+
+bool SpectrumAnalyzer::init(const double sampleRate, const uint32_t fftSize)
+{
+    if (fftSize < kMinSize || fftSize > kMaxSize || ! fFFT.init(fftSize))
+        return false;
+
+    delete[] fInput;
+    delete[] fWindowed;
+    delete[] fWindow;
+    delete[] fSpectrum;
+    delete[] fBandFirst;
+    delete[] fBandEnd;
+    delete[] fBandFrequency;
+    delete[] fBandPower;
+    delete[] fBandLevel;
+
+    fSampleRate = sampleRate;
+    fSize = fftSize;
+
+    fInput    = new float[fftSize];
+    fWindowed = new float[fftSize];
+    fWindow   = new float[fftSize];
+    fSpectrum = new float[fftSize+2];
+
+    // Hann window, scaled so a full-scale sine reads 0 dB
+    double windowSum = 0.0;
+
+    for (uint32_t i=0; i < fftSize; ++i)
+    {
+        fWindow[i] = float(0.5 - 0.5 * std::cos(2.0 * M_PI * double(i) / double(fftSize)));
+        windowSum += fWindow[i];
+    }
+
+    for (uint32_t i=0; i < fftSize; ++i)
+        fWindow[i] *= float(2.0 / windowSum);
+
+    const double nyquist = sampleRate / 2.0;
+    const double lowest  = 20.0;
+    const double highest = (nyquist < 20000.0) ? nyquist : 20000.0;
+
+    fBands = uint32_t(std::log2(highest / lowest) * kBandsPerOctave);
+
+    fBandFirst     = new uint32_t[fBands];
+    fBandEnd       = new uint32_t[fBands];
+    fBandFrequency = new float[fBands];
+    fBandPower     = new float[fBands];
+    fBandLevel     = new float[fBands];
+
+    const double binWidth = sampleRate / double(fftSize);
+
+    for (uint32_t i=0; i < fBands; ++i)
+    {
+        const double low    = lowest * std::pow(2.0, double(i)   / kBandsPerOctave);
+        const double high   = lowest * std::pow(2.0, double(i+1) / kBandsPerOctave);
+        const double center = std::sqrt(low * high);
+
+        uint32_t first = uint32_t(std::ceil(low / binWidth));
+        uint32_t end   = uint32_t(std::ceil(high / binWidth));
+
+        // narrower than a bin, use the one nearest to the center
+        if (end <= first)
+        {
+            first = uint32_t(center / binWidth + 0.5);
+            end   = first + 1;
+        }
+
+        if (end > fftSize/2+1)
+            end = fftSize/2+1;
+        if (first >= end)
+            first = end-1;
+
+        fBandFirst[i]     = first;
+        fBandEnd[i]       = end;
+        fBandFrequency[i] = float(center);
+    }
+
+    reset();
+    return true;
+}
+
+void SpectrumAnalyzer::reset()
+{
+    fFill = 0;
+
+    for (uint32_t i=0; i < fBands; ++i)
+    {
+        fBandPower[i] = 0.0f;
+        fBandLevel[i] = kFloor;
+    }
+}
+
+uint32_t SpectrumAnalyzer::getSize() const
+{
+    return fSize;
+}
+
+uint32_t SpectrumAnalyzer::getBands() const
+{
+    return fBands;
+}
+
+bool SpectrumAnalyzer::addSamples(const float* samples, uint32_t count)
+{
+    if (fSize == 0)
+        return false;
+
+    bool analyzed = false;
+
+    while (count > 0)
+    {
+        uint32_t toCopy = fSize - fFill;
+
+        if (toCopy > count)
+            toCopy = count;
+
+        std::memcpy(fInput + fFill, samples, sizeof(float)*toCopy);
+
+        fFill   += toCopy;
+        samples += toCopy;
+        count   -= toCopy;
+
+        if (fFill == fSize)
+        {
+            analyze();
+            analyzed = true;
+
+            // keep the second half, next frame starts from there
+            std::memmove(fInput, fInput + fSize/2, sizeof(float)*(fSize/2));
+            fFill = fSize/2;
+        }
+    }
+
+    return analyzed;
+}
+
+float SpectrumAnalyzer::getBandFrequency(const uint32_t band) const
+{
+    return (band < fBands) ? fBandFrequency[band] : 0.0f;
+}
+
+float SpectrumAnalyzer::getBandLevel(const uint32_t band) const
+{
+    return (band < fBands) ? fBandLevel[band] : kFloor;
+}
+
+void SpectrumAnalyzer::analyze()
+{
+    for (uint32_t i=0; i < fSize; ++i)
+        fWindowed[i] = fInput[i] * fWindow[i];
+
+    fFFT.forward(fWindowed, fSpectrum);
+
+    for (uint32_t i=0; i < fBands; ++i)
+    {
+        float power = 0.0f;
+
+        for (uint32_t j=fBandFirst[i]; j < fBandEnd[i]; ++j)
+            power += fSpectrum[j*2]*fSpectrum[j*2] + fSpectrum[j*2+1]*fSpectrum[j*2+1];
+
+        // summed, like an octave-band analyzer; the Hann window spreads a
+        // sine over 1.5 bins worth of power, take that out so it reads 0 dB
+        power *= 1.0f / 1.5f;
+
+        fBandPower[i] = fBandPower[i] * kTimeSmoothing + power * (1.0f - kTimeSmoothing);
+        fBandLevel[i] = (fBandPower[i] > 1e-12f) ? 10.0f * std::log10(fBandPower[i]) : kFloor;
+    }
+}
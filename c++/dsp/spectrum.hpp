@@ -0,0 +1,77 @@
+/*
+ * Spectrum analyzer, overlapped FFT with logarithmic bands
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __SPECTRUM_HPP__
+#define __SPECTRUM_HPP__
+
+#include "fft.hpp"
+
+// -------------------------------
+// GUI side, never used in the JACK thread.
+// Collects samples until a Hann-windowed frame of 'fftSize' is complete,
+// analyzes it, and keeps the second half for the next one (50% overlap).
+// FFT bins are summed into kBandsPerOctave bands per octave from 20 Hz
+// up to 20 kHz (or Nyquist), then smoothed over time.
+
+class SpectrumAnalyzer
+{
+public:
+    static const uint32_t kMinSize = 1024;
+    static const uint32_t kMaxSize = 32768;
+    static const uint32_t kBandsPerOctave = 12;
+    static const float    kFloor; // dB returned for silent bands
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer();
+
+    // not realtime safe, 'fftSize' must be a power of 2 in [kMinSize, kMaxSize]
+    bool init(double sampleRate, uint32_t fftSize);
+    void reset();
+
+    uint32_t getSize() const;
+    uint32_t getBands() const;
+
+    // returns true if at least one frame was analyzed
+    bool addSamples(const float* samples, uint32_t count);
+
+    float getBandFrequency(uint32_t band) const; // center, in Hz
+    float getBandLevel(uint32_t band) const;     // dB, 0 for a full-scale sine
+
+private:
+    double   fSampleRate;
+    uint32_t fSize;
+    uint32_t fFill;
+    uint32_t fBands;
+
+    RealFFT fFFT;
+
+    float* fInput;
+    float* fWindowed;
+    float* fWindow;
+    float* fSpectrum;
+
+    // first and last+1 FFT bin of each band
+    uint32_t* fBandFirst;
+    uint32_t* fBandEnd;
+    float*    fBandFrequency;
+    float*    fBandPower;
+    float*    fBandLevel;
+
+    void analyze();
+};
+
+#endif // __SPECTRUM_HPP__
@@ -0,0 +1,92 @@
+/*
+ * Stereo phase correlation and goniometer
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "stereoscope.hpp"
+
+#include <cmath>
+
+static const float kInvSqrt2 = 0.70710678f;
+
+// -------------------------------
+
+void stereoscope_sums(const float* const left, const float* const right, const uint32_t frames, StereoSums& sums)
+{
+    float lr = 0.0f, ll = 0.0f, rr = 0.0f;
+
+    for (uint32_t i=0; i < frames; ++i)
+    {
+        lr += left[i] * right[i];
+        ll += left[i] * left[i];
+        rr += right[i] * right[i];
+    }
+
+    sums.lr = lr;
+    sums.ll = ll;
+    sums.rr = rr;
+}
+
+uint32_t stereoscope_decimate(const float* const left, const float* const right, const uint32_t frames,
+                              const uint32_t stride, uint32_t& phase, GoniometerPoint* const points, const uint32_t maxPoints)
+{
+    uint32_t count = 0;
+    uint32_t i = phase;
+
+    for (; i < frames && count < maxPoints; i += stride, ++count)
+    {
+        points[count].side = (right[i] - left[i]) * kInvSqrt2;
+        points[count].mid  = (left[i] + right[i]) * kInvSqrt2;
+    }
+
+    // where the next block starts, even if points were cut by 'maxPoints'
+    phase = (i < frames) ? stride - (frames - phase) % stride : i - frames;
+
+    if (phase == stride)
+        phase = 0;
+
+    return count;
+}
+
+// -------------------------------
+
+CorrelationMeter::CorrelationMeter()
+{
+    reset();
+}
+
+void CorrelationMeter::reset()
+{
+    fLR = fLL = fRR = 0.0;
+}
+
+void CorrelationMeter::addBlock(const StereoSums& sums, const float decay)
+{
+    fLR = fLR * decay + sums.lr;
+    fLL = fLL * decay + sums.ll;
+    fRR = fRR * decay + sums.rr;
+}
+
+float CorrelationMeter::getCorrelation() const
+{
+    const double energy = std::sqrt(fLL * fRR);
+
+    if (energy < 1e-12)
+        return 0.0f;
+
+    const double correlation = fLR / energy;
+
+    return float(correlation > 1.0 ? 1.0 : (correlation < -1.0 ? -1.0 : correlation));
+}
@@ -0,0 +1,65 @@
+/*
+ * Stereo phase correlation and goniometer
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __STEREOSCOPE_HPP__
+#define __STEREOSCOPE_HPP__
+
+#include <stdint.h>
+
+// -------------------------------
+// Realtime side, both O(frames) with no data-dependent branches.
+
+// sums of one block, correlation is lr / sqrt(ll * rr)
+struct StereoSums {
+    float lr;
+    float ll;
+    float rr;
+};
+
+struct GoniometerPoint {
+    float side; // (R - L) / sqrt(2), horizontal, so left leans to the upper left
+    float mid;  // (L + R) / sqrt(2), vertical
+};
+
+void stereoscope_sums(const float* left, const float* right, uint32_t frames, StereoSums& sums);
+
+// writes one point every 'stride' frames, starting at 'phase'; returns the
+// number of points and updates 'phase' so the stride carries across blocks
+uint32_t stereoscope_decimate(const float* left, const float* right, uint32_t frames,
+                              uint32_t stride, uint32_t& phase, GoniometerPoint* points, uint32_t maxPoints);
+
+// -------------------------------
+// GUI side: correlation over a sliding (exponentially decaying) window.
+
+class CorrelationMeter
+{
+public:
+    CorrelationMeter();
+
+    void reset();
+
+    // 'decay' is applied once per block, before adding it
+    void addBlock(const StereoSums& sums, float decay);
+
+    // -1 (out of phase) to +1 (mono), 0 when silent
+    float getCorrelation() const;
+
+private:
+    double fLR, fLL, fRR;
+};
+
+#endif // __STEREOSCOPE_HPP__
@@ -0,0 +1,330 @@
+/*
+ * True-peak detection (ITU-R BS.1770 annex 2), with runtime CPU dispatch
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "truepeak.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && (__GNUC__ * 100 + __GNUC_MINOR__) >= 409 && (defined(__x86_64__) || defined(__i386__))
+# define TRUEPEAK_X86
+# include <immintrin.h>
+#endif
+
+// -------------------------------
+// BS.1770-4 annex 2 interpolation filter, one row per phase
+
+static const float kPhases[4][12] = {
+    {  0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f, -0.0594482421875f,  0.1373291015625f,
+       0.9721679687500f, -0.1022949218750f,  0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+    { -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f, -0.1665039062500f,  0.4650878906250f,
+       0.7797851562500f, -0.2003173828125f,  0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+    { -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f, -0.2003173828125f,  0.7797851562500f,
+       0.4650878906250f, -0.1665039062500f,  0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+    { -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f, -0.1022949218750f,  0.9721679687500f,
+       0.1373291015625f, -0.0594482421875f,  0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f }
+};
+
+// same coefficients, one row per tap (all 4 phases of a tap in one vector)
+static float kTapCoeffs[12][4] __attribute__((aligned(32)));
+
+static const struct TruePeakInit {
+    TruePeakInit() {
+        for (int tap=0; tap < 12; ++tap)
+            for (int phase=0; phase < 4; ++phase)
+                kTapCoeffs[tap][phase] = kPhases[phase][tap];
+    }
+} _truePeakInit;
+
+// -------------------------------
+// Kernels, 'input' starts with 11 samples of history
+
+static float truepeak_scalar(const float* const input, const uint32_t frames)
+{
+    float peak = 0.0f;
+
+    for (uint32_t n=0; n < frames; ++n)
+    {
+        const float* const x = input + n + 11;
+
+        for (int phase=0; phase < 4; ++phase)
+        {
+            float acc = 0.0f;
+
+            for (int tap=0; tap < 12; ++tap)
+                acc += kPhases[phase][tap] * x[-tap];
+
+            acc = std::fabs(acc);
+
+            if (acc > peak)
+                peak = acc;
+        }
+    }
+
+    return peak;
+}
+
+#ifdef TRUEPEAK_X86
+
+// four input samples per iteration, with independent accumulators so the adds can overlap
+__attribute__((target("sse2")))
+static float truepeak_sse2(const float* const input, const uint32_t frames)
+{
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    __m128 coeffs[12];
+
+    for (int tap=0; tap < 12; ++tap)
+        coeffs[tap] = _mm_load_ps(kTapCoeffs[tap]);
+
+    __m128 peak1 = _mm_setzero_ps();
+    __m128 peak2 = _mm_setzero_ps();
+    uint32_t n = 0;
+
+    for (; n+4 <= frames; n += 4)
+    {
+        const float* const x = input + n + 11;
+
+        __m128 acc0 = _mm_mul_ps(coeffs[0], _mm_set1_ps(x[0]));
+        __m128 acc1 = _mm_mul_ps(coeffs[0], _mm_set1_ps(x[1]));
+        __m128 acc2 = _mm_mul_ps(coeffs[0], _mm_set1_ps(x[2]));
+        __m128 acc3 = _mm_mul_ps(coeffs[0], _mm_set1_ps(x[3]));
+
+        for (int tap=1; tap < 12; ++tap)
+        {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(coeffs[tap], _mm_set1_ps(x[0-tap])));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(coeffs[tap], _mm_set1_ps(x[1-tap])));
+            acc2 = _mm_add_ps(acc2, _mm_mul_ps(coeffs[tap], _mm_set1_ps(x[2-tap])));
+            acc3 = _mm_add_ps(acc3, _mm_mul_ps(coeffs[tap], _mm_set1_ps(x[3-tap])));
+        }
+
+        peak1 = _mm_max_ps(peak1, _mm_max_ps(_mm_and_ps(acc0, absMask), _mm_and_ps(acc1, absMask)));
+        peak2 = _mm_max_ps(peak2, _mm_max_ps(_mm_and_ps(acc2, absMask), _mm_and_ps(acc3, absMask)));
+    }
+
+    for (; n < frames; ++n)
+    {
+        const float* const x = input + n + 11;
+
+        __m128 acc = _mm_mul_ps(coeffs[0], _mm_set1_ps(x[0]));
+
+        for (int tap=1; tap < 12; ++tap)
+            acc = _mm_add_ps(acc, _mm_mul_ps(coeffs[tap], _mm_set1_ps(x[-tap])));
+
+        peak1 = _mm_max_ps(peak1, _mm_and_ps(acc, absMask));
+    }
+
+    peak1 = _mm_max_ps(peak1, peak2);
+    peak1 = _mm_max_ps(peak1, _mm_shuffle_ps(peak1, peak1, _MM_SHUFFLE(1, 0, 3, 2)));
+    peak1 = _mm_max_ps(peak1, _mm_shuffle_ps(peak1, peak1, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtss_f32(peak1);
+}
+
+// same as above with two input samples per vector (8 output samples)
+__attribute__((target("avx")))
+static inline __m256 truepeak_avx_pair(const float* const x)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(x[0])), _mm_set1_ps(x[1]), 1);
+}
+
+__attribute__((target("avx")))
+static float truepeak_avx(const float* const input, const uint32_t frames)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+    __m256 coeffs[12];
+
+    for (int tap=0; tap < 12; ++tap)
+        coeffs[tap] = _mm256_broadcast_ps((const __m128*)kTapCoeffs[tap]);
+
+    __m256 peak1 = _mm256_setzero_ps();
+    __m256 peak2 = _mm256_setzero_ps();
+    uint32_t n = 0;
+
+    for (; n+4 <= frames; n += 4)
+    {
+        const float* const x = input + n + 11;
+
+        __m256 acc0 = _mm256_mul_ps(coeffs[0], truepeak_avx_pair(x));
+        __m256 acc1 = _mm256_mul_ps(coeffs[0], truepeak_avx_pair(x+2));
+
+        for (int tap=1; tap < 12; ++tap)
+        {
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(coeffs[tap], truepeak_avx_pair(x-tap)));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(coeffs[tap], truepeak_avx_pair(x+2-tap)));
+        }
+
+        peak1 = _mm256_max_ps(peak1, _mm256_and_ps(acc0, absMask));
+        peak2 = _mm256_max_ps(peak2, _mm256_and_ps(acc1, absMask));
+    }
+
+    peak1 = _mm256_max_ps(peak1, peak2);
+
+    __m128 peak4 = _mm_max_ps(_mm256_castps256_ps128(peak1), _mm256_extractf128_ps(peak1, 1));
+
+    for (; n < frames; ++n)
+    {
+        const float* const x = input + n + 11;
+
+        __m128 acc = _mm_mul_ps(_mm256_castps256_ps128(coeffs[0]), _mm_set1_ps(x[0]));
+
+        for (int tap=1; tap < 12; ++tap)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm256_castps256_ps128(coeffs[tap]), _mm_set1_ps(x[-tap])));
+
+        peak4 = _mm_max_ps(peak4, _mm_and_ps(acc, _mm256_castps256_ps128(absMask)));
+    }
+
+    peak4 = _mm_max_ps(peak4, _mm_shuffle_ps(peak4, peak4, _MM_SHUFFLE(1, 0, 3, 2)));
+    peak4 = _mm_max_ps(peak4, _mm_shuffle_ps(peak4, peak4, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtss_f32(peak4);
+}
+
+#endif // TRUEPEAK_X86
+
+// -------------------------------
+
+TruePeakDetector::TruePeakDetector()
+    : fChannels(0),
+      fHistory(nullptr),
+      fScratch(nullptr),
+      fImpl(IMPL_SCALAR),
+      fFunc(truepeak_scalar)
+{
+    // the scalar loop is vectorized by the compiler and is as fast as the
+    // hand-written SSE2 one, which is only kept for setImpl() and the bench
+    for (int i=IMPL_COUNT-1; i >= 0; --i)
+    {
+        if (i == IMPL_SSE2)
+            continue;
+        if (setImpl(Impl(i)))
+            break;
+    }
+}
+
+TruePeakDetector::~TruePeakDetector()
+{
+    delete[] fHistory;
+    delete[] fScratch;
+}
+
+void TruePeakDetector::init(const uint32_t channels)
+{
+    delete[] fHistory;
+    delete[] fScratch;
+
+    fChannels = channels;
+    fHistory  = new float[channels*(kTaps-1)];
+    fScratch  = new float[kTaps-1+kChunkFrames];
+
+    reset();
+}
+
+void TruePeakDetector::reset()
+{
+    std::memset(fHistory, 0, sizeof(float)*fChannels*(kTaps-1));
+}
+
+bool TruePeakDetector::setImpl(const Impl impl)
+{
+    if (ProcessFunc func = getFunc(impl))
+    {
+        fImpl = impl;
+        fFunc = func;
+        return true;
+    }
+
+    return false;
+}
+
+TruePeakDetector::Impl TruePeakDetector::getImpl() const
+{
+    return fImpl;
+}
+
+const char* TruePeakDetector::getImplName(const Impl impl)
+{
+    switch (impl)
+    {
+    case IMPL_SCALAR:
+        return "scalar";
+    case IMPL_SSE2:
+        return "sse2";
+    case IMPL_AVX:
+        return "avx";
+    default:
+        return "unknown";
+    }
+}
+
+void TruePeakDetector::process(const float* const* const buffers, const uint32_t frames, float* const peaks)
+{
+    process(buffers, nullptr, fChannels, frames, peaks);
+}
+
+void TruePeakDetector::process(const float* const* const buffers, const uint32_t* const channels, const uint32_t count,
+                               const uint32_t frames, float* const peaks)
+{
+    static const uint32_t kHistorySize = kTaps-1;
+
+    for (uint32_t k=0; k < count; ++k)
+    {
+        const uint32_t c = (channels != nullptr) ? channels[k] : k;
+        float* const history = fHistory + c*kHistorySize;
+        const float* const in = buffers[k];
+        float peak = 0.0f;
+
+        std::memcpy(fScratch, history, sizeof(float)*kHistorySize);
+
+        for (uint32_t offset=0; offset < frames; offset += kChunkFrames)
+        {
+            const uint32_t chunk = (frames - offset < kChunkFrames) ? frames - offset : kChunkFrames;
+
+            std::memcpy(fScratch + kHistorySize, in + offset, sizeof(float)*chunk);
+
+            const float chunkPeak = fFunc(fScratch, chunk);
+
+            if (chunkPeak > peak)
+                peak = chunkPeak;
+
+            std::memmove(fScratch, fScratch + chunk, sizeof(float)*kHistorySize);
+        }
+
+        std::memcpy(history, fScratch, sizeof(float)*kHistorySize);
+        peaks[k] = peak;
+    }
+}
+
+TruePeakDetector::ProcessFunc TruePeakDetector::getFunc(const Impl impl)
+{
+    switch (impl)
+    {
+    case IMPL_SCALAR:
+        return truepeak_scalar;
+#ifdef TRUEPEAK_X86
+    case IMPL_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2") ? truepeak_sse2 : nullptr;
+    case IMPL_AVX:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx") ? truepeak_avx : nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ * True-peak detection (ITU-R BS.1770 annex 2), with runtime CPU dispatch
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __TRUEPEAK_HPP__
+#define __TRUEPEAK_HPP__
+
+#include <stdint.h>
+
+// -------------------------------
+// 4x oversampling through a 48-tap polyphase FIR (12 taps per phase).
+// All 4 phases of one input sample are computed together as one vector,
+// so each input sample costs 12 vector multiply-adds.
+
+class TruePeakDetector
+{
+public:
+    enum Impl {
+        IMPL_SCALAR = 0,
+        IMPL_SSE2   = 1,
+        IMPL_AVX    = 2,
+        IMPL_COUNT  = 3
+    };
+
+    TruePeakDetector();
+    ~TruePeakDetector();
+
+    // not realtime safe
+    void init(uint32_t channels);
+    void reset();
+
+    // force an implementation, returns false if the CPU (or build) does not support it
+    bool setImpl(Impl impl);
+    Impl getImpl() const;
+    static const char* getImplName(Impl impl);
+
+    // peaks[i] = highest absolute value of the oversampled channel i during this block
+    void process(const float* const* buffers, uint32_t frames, float* peaks);
+
+    // same for 'count' channels only, buffers[k] and peaks[k] belong to channel channels[k]
+    void process(const float* const* buffers, const uint32_t* channels, uint32_t count, uint32_t frames, float* peaks);
+
+private:
+    static const uint32_t kTaps        = 12;
+    static const uint32_t kChunkFrames = 256;
+
+    typedef float (*ProcessFunc)(const float* input, uint32_t frames);
+
+    uint32_t    fChannels;
+    float*      fHistory; // last kTaps-1 input samples of every channel
+    float*      fScratch; // history followed by the current chunk
+    Impl        fImpl;
+    ProcessFunc fFunc;
+
+    static ProcessFunc getFunc(Impl impl);
+};
+
+#endif // __TRUEPEAK_HPP__
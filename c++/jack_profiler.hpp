@@ -0,0 +1,254 @@
+/*
+ * Per-cycle DSP time profiler for JACK clients
+ * Copyright (C) 2012-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __JACK_PROFILER_HPP__
+#define __JACK_PROFILER_HPP__
+
+#include "jackbridge/JackBridge.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdint.h>
+
+// Single writer (JACK thread), any number of readers.
+// Wrap the process callback body in begin()/end(). Each cycle's duration goes
+// into a log-linear histogram (8 steps per octave, so percentiles are within
+// 12.5%) of relaxed atomic counters, next to the period JACK reports for the
+// cycle and how late into it the callback started.
+// Readers never block the JACK thread; a reset is only requested here and
+// done by the writer at the end of its next cycle.
+
+class JackProfiler
+{
+public:
+    struct Stats {
+        uint64_t cycles;
+        uint64_t overBudget;  // cycles that took longer than the period
+        float    p50, p99;    // microseconds
+        float    max;         // microseconds
+        float    period;      // microseconds, the per-cycle budget
+        float    maxLateness; // microseconds from cycle start to begin()
+    };
+
+    JackProfiler()
+        : fClient(nullptr),
+          fStart(0),
+          fStartTime(0)
+    {
+        fCycles.store(0);
+        fOverBudget.store(0);
+        fMax.store(0);
+        fMaxLateness.store(0);
+        fPeriod.store(0);
+        fResetRequested.store(false);
+
+        for (uint32_t i=0; i < kBucketCount; ++i)
+            fBuckets[i].store(0);
+    }
+
+    // not realtime safe, call before activating the client
+    void init(jack_client_t* const client)
+    {
+        fClient = client;
+    }
+
+    bool isEnabled() const
+    {
+        return (fClient != nullptr);
+    }
+
+    // JACK thread
+    void begin()
+    {
+        if (fClient == nullptr)
+            return;
+
+        fStartTime = jackbridge_get_time();
+        fStart     = now();
+    }
+
+    // JACK thread
+    void end()
+    {
+        if (fClient == nullptr)
+            return;
+
+        const uint64_t elapsed = now() - fStart;
+
+        if (fResetRequested.load(std::memory_order_acquire))
+        {
+            for (uint32_t i=0; i < kBucketCount; ++i)
+                fBuckets[i].store(0, std::memory_order_relaxed);
+
+            fCycles.store(0, std::memory_order_relaxed);
+            fOverBudget.store(0, std::memory_order_relaxed);
+            fMax.store(0, std::memory_order_relaxed);
+            fMaxLateness.store(0, std::memory_order_relaxed);
+            fResetRequested.store(false, std::memory_order_release);
+        }
+
+        // only this thread writes, so no read-modify-write is needed
+        std::atomic<uint32_t>& bucket(fBuckets[getBucket(elapsed)]);
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        fCycles.store(fCycles.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (elapsed > fMax.load(std::memory_order_relaxed))
+            fMax.store(elapsed, std::memory_order_relaxed);
+
+        jack_nframes_t frames;
+        jack_time_t    cycleStart, nextStart;
+        float          period;
+
+        if (! jackbridge_get_cycle_times(fClient, &frames, &cycleStart, &nextStart, &period))
+            return;
+
+        fPeriod.store(uint32_t(period), std::memory_order_relaxed);
+
+        if (elapsed > uint64_t(period * 1000.0f))
+            fOverBudget.store(fOverBudget.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (fStartTime > cycleStart && fStartTime - cycleStart > fMaxLateness.load(std::memory_order_relaxed))
+            fMaxLateness.store(fStartTime - cycleStart, std::memory_order_relaxed);
+    }
+
+    // any thread
+    void reset()
+    {
+        fResetRequested.store(true, std::memory_order_release);
+    }
+
+    // any thread, returns false if nothing was measured yet
+    bool getStats(Stats& stats) const
+    {
+        uint32_t counts[kBucketCount];
+        uint64_t total = 0;
+
+        for (uint32_t i=0; i < kBucketCount; ++i)
+            total += (counts[i] = fBuckets[i].load(std::memory_order_relaxed));
+
+        if (total == 0)
+            return false;
+
+        stats.cycles      = fCycles.load(std::memory_order_relaxed);
+        stats.overBudget  = fOverBudget.load(std::memory_order_relaxed);
+        stats.max         = float(fMax.load(std::memory_order_relaxed)) / 1000.0f;
+        stats.period      = float(fPeriod.load(std::memory_order_relaxed));
+        stats.maxLateness = float(fMaxLateness.load(std::memory_order_relaxed));
+        stats.p50         = getPercentile(counts, total, 0.50) / 1000.0f;
+        stats.p99         = getPercentile(counts, total, 0.99) / 1000.0f;
+
+        // bucket bounds are rounded up, never report more than was measured
+        if (stats.p50 > stats.max)
+            stats.p50 = stats.max;
+        if (stats.p99 > stats.max)
+            stats.p99 = stats.max;
+
+        return true;
+    }
+
+    // any thread, one line on stdout
+    void dump(const char* const name) const
+    {
+        Stats stats;
+
+        if (! getStats(stats))
+            return;
+
+        if (stats.period > 0.0f)
+            std::printf("%s: %llu cycles, DSP p50 %.1f us (%.1f%%), p99 %.1f us (%.1f%%), max %.1f us (%.1f%%), "
+                        "%llu over budget, started up to %.0f us late, period %.0f us\n",
+                        name, (unsigned long long)stats.cycles,
+                        stats.p50, 100.0f * stats.p50 / stats.period,
+                        stats.p99, 100.0f * stats.p99 / stats.period,
+                        stats.max, 100.0f * stats.max / stats.period,
+                        (unsigned long long)stats.overBudget, stats.maxLateness, stats.period);
+        else
+            std::printf("%s: %llu cycles, DSP p50 %.1f us, p99 %.1f us, max %.1f us\n",
+                        name, (unsigned long long)stats.cycles, stats.p50, stats.p99, stats.max);
+    }
+
+private:
+    // nanoseconds, values from 2^32 up all land in the last bucket (over 4 s)
+    static const uint32_t kSubBits     = 3;
+    static const uint32_t kSubBuckets  = 1 << kSubBits;
+    static const uint32_t kBucketCount = (32 - kSubBits + 1) * kSubBuckets;
+
+    jack_client_t* fClient;
+    uint64_t       fStart;
+    jack_time_t    fStartTime;
+
+    std::atomic<uint32_t> fBuckets[kBucketCount];
+    std::atomic<uint64_t> fCycles;
+    std::atomic<uint64_t> fOverBudget;
+    std::atomic<uint64_t> fMax;
+    std::atomic<uint64_t> fMaxLateness;
+    std::atomic<uint32_t> fPeriod;
+    std::atomic<bool>     fResetRequested;
+
+    static uint64_t now()
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static uint32_t getBucket(uint64_t nanoseconds)
+    {
+        if (nanoseconds > 0xffffffff)
+            return kBucketCount - 1;
+
+        const uint32_t value = uint32_t(nanoseconds);
+
+        if (value < kSubBuckets)
+            return value;
+
+        // top bit selects the octave, the next kSubBits the step inside it
+        const uint32_t octave = 31 - __builtin_clz(value);
+        const uint32_t step   = (value >> (octave - kSubBits)) & (kSubBuckets - 1);
+
+        return (octave - kSubBits + 1) * kSubBuckets + step;
+    }
+
+    // upper bound of a bucket, in nanoseconds
+    static double getBucketLimit(uint32_t bucket)
+    {
+        if (bucket < kSubBuckets)
+            return double(bucket + 1);
+
+        const uint32_t octave = bucket / kSubBuckets + kSubBits - 1;
+        const uint32_t step   = bucket % kSubBuckets;
+
+        return double(uint64_t(kSubBuckets + step + 1) << (octave - kSubBits));
+    }
+
+    static float getPercentile(const uint32_t* const counts, const uint64_t total, const double fraction)
+    {
+        const uint64_t target = uint64_t(fraction * double(total));
+        uint64_t count = 0;
+
+        for (uint32_t i=0; i < kBucketCount; ++i)
+        {
+            count += counts[i];
+
+            if (count > target)
+                return float(getBucketLimit(i));
+        }
+
+        return float(getBucketLimit(kBucketCount - 1));
+    }
+};
+
+#endif // __JACK_PROFILER_HPP__
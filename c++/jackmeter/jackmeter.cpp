@@ -24,51 +24,106 @@
 #define VERSION "0.8.1"
 
 #include "../jack_utils.hpp"
+#include "../jack_profiler.hpp"
 #include "../widgets/digitalpeakmeter.hpp"
+#include "../widgets/digitalpeakmeterbank.hpp"
+#include "../widgets/framescheduler.hpp"
+#include "../widgets/goniometer.hpp"
+#include "../widgets/levelhistory.hpp"
+#include "../widgets/spectrumview.hpp"
+#include "meterdaemon.hpp"
 
+#include <cerrno>
 #include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
 #include <QtGui/QIcon>
 #include <QtWidgets/QApplication>
+#include <QtWidgets/QHBoxLayout>
+#include <QtWidgets/QVBoxLayout>
 #include <QtWidgets/QMessageBox>
 
 // -------------------------------
 
-volatile double x_portValue1 = 0.0;
-volatile double x_portValue2 = 0.0;
 volatile bool x_isOutput = true;
+volatile bool x_headless = false;
+volatile bool x_daemon = false;
+volatile bool x_loudness = false;
+volatile bool x_truePeak = false;
+volatile bool x_goniometer = false;
 volatile bool x_needReconnect = false;
+volatile bool x_printStats = false;
+volatile bool x_profile = false;
+volatile bool x_bank = false;
 volatile bool x_quitNow = false;
 
+int x_ballistics = 0; // a DigitalPeakMeter::Ballistics, 0 for the default smooth release
+int x_peakHold = 0;   // milliseconds
+int x_dbFloor = 0;    // 0 for a linear scale
+
 jack_client_t* jClient = nullptr;
-jack_port_t* jPort1 = nullptr;
-jack_port_t* jPort2 = nullptr;
 
+MeterEngine  gEngine;
+JackProfiler gProfiler;
+MeterShm    gSharedTable;
+MeterDaemon gDaemon;
 QString gClientName;
 
+// connection changes, from the JACK notification thread to the GUI
+struct ConnectionEvent {
+    jack_port_id_t source;
+    jack_port_id_t target;
+    bool connect;
+};
+
+RingBuffer<ConnectionEvent> gConnectionEvents;
+
+// sources connected to each of our inputs, kept from the events above
+QVector<QSet<QString> > gConnectedSources;
+
+// how much reconnection work was done, for '-stats'
+struct ReconnectStats {
+    uint events;
+    uint relevant;
+    uint jackCalls;
+    uint rescans;
+} gReconnectStats = { 0, 0, 0, 0 };
+
 // -------------------------------
 // JACK callbacks
 
-int process_callback(const jack_nframes_t nframes, void*)
+int process_callback(const jack_nframes_t nframes, void* const arg)
 {
-    float* const jOut1 = (float*)jackbridge_port_get_buffer(jPort1, nframes);
-    float* const jOut2 = (float*)jackbridge_port_get_buffer(jPort2, nframes);
+    gProfiler.begin();
+    ((MeterEngine*)arg)->process(nframes);
+    gProfiler.end();
+    return 0;
+}
 
-    for (jack_nframes_t i = 0; i < nframes; i++)
-    {
-        if (std::abs(jOut1[i]) > x_portValue1)
-            x_portValue1 = std::abs(jOut1[i]);
+void port_callback(jack_port_id_t a, jack_port_id_t b, int connect, void*)
+{
+    if (! x_isOutput)
+        return;
 
-        if (std::abs(jOut2[i]) > x_portValue2)
-            x_portValue2 = std::abs(jOut2[i]);
-    }
+    const ConnectionEvent event = { a, b, connect != 0 };
 
-    return 0;
+    // if the GUI fell behind, fall back to a full rescan
+    if (! gConnectionEvents.put(event))
+        x_needReconnect = true;
 }
 
-void port_callback(jack_port_id_t, jack_port_id_t, int, void*)
+void port_registration_callback(jack_port_id_t, int, void*)
 {
-    if (x_isOutput)
-        x_needReconnect = true;
+    gDaemon.requestScan();
+}
+
+int port_rename_callback(jack_port_id_t, const char*, const char*, void*)
+{
+    gDaemon.requestScan();
+    return 0;
 }
 
 #ifdef HAVE_JACKSESSION
@@ -95,124 +150,737 @@ void session_callback(jack_session_event_t* const event, void* const arg)
 // -------------------------------
 // helpers
 
+// full rescan, used at startup and if connection events were lost
 void reconnect_ports()
 {
     x_needReconnect = false;
+    ++gReconnectStats.rescans;
 
-    const QString nameIn1(gClientName+":in1");
-    const QString nameIn2(gClientName+":in2");
-
-    if (x_isOutput)
+    for (uint32_t i=0; i < gEngine.getChannels(); ++i)
     {
-        jack_port_t* const jPlayPort1 = jackbridge_port_by_name(jClient, x_isOutput ? "system:playback_1" : "system:capture_1");
-        jack_port_t* const jPlayPort2 = jackbridge_port_by_name(jClient, x_isOutput ? "system:playback_2" : "system:capture_2");
-        std::vector<char*> jPortList1(jackbridge_port_get_all_connections_as_vector(jClient, jPlayPort1));
-        std::vector<char*> jPortList2(jackbridge_port_get_all_connections_as_vector(jClient, jPlayPort2));
+        const QString nameIn(QString("%1:in%2").arg(gClientName).arg(i+1));
+        jack_port_t* const jPort(gEngine.getPort(i));
+
+        if (x_isOutput)
+        {
+            QSet<QString>& connected(gConnectedSources[i]);
+            connected.clear();
+
+            if (const char** const connections = jackbridge_port_get_connections(jPort))
+            {
+                for (int j=0; connections[j] != nullptr; ++j)
+                    connected.insert(QString::fromUtf8(connections[j]));
+
+                jackbridge_free(connections);
+            }
 
-        foreach (char* const& thisPortName, jPortList1)
+            const QString namePlay(QString("system:playback_%1").arg(i+1));
+            jack_port_t* const jPlayPort = jackbridge_port_by_name(jClient, namePlay.toUtf8().constData());
+
+            if (jPlayPort == nullptr)
+                continue;
+
+            std::vector<char*> jPortList(jackbridge_port_get_all_connections_as_vector(jClient, jPlayPort));
+
+            foreach (char* const& thisPortName, jPortList)
+            {
+                const QString sourceName(QString::fromUtf8(thisPortName));
+                jack_port_t* const thisPort = jackbridge_port_by_name(jClient, thisPortName);
+
+                if (! (jackbridge_port_is_mine(jClient, thisPort) || connected.contains(sourceName)))
+                {
+                    ++gReconnectStats.jackCalls;
+
+                    jackbridge_connect(jClient, thisPortName, nameIn.toUtf8().constData());
+                    connected.insert(sourceName);
+                }
+
+                free(thisPortName);
+            }
+        }
+        else
         {
-            jack_port_t* const thisPort = jackbridge_port_by_name(jClient, thisPortName);
+            const QString nameCapture(QString("system:capture_%1").arg(i+1));
+            const QByteArray nameCaptureUtf8(nameCapture.toUtf8());
+
+            if (jackbridge_port_by_name(jClient, nameCaptureUtf8.constData()) != nullptr)
+                if (! jackbridge_port_connected_to(jPort, nameCaptureUtf8.constData()))
+                    jackbridge_connect(jClient, nameCaptureUtf8.constData(), nameIn.toUtf8().constData());
+        }
+    }
+}
 
-            if (! (jackbridge_port_is_mine(jClient, thisPort) || jackbridge_port_connected_to(jPort1, thisPortName)))
-                jackbridge_connect(jClient, thisPortName, nameIn1.toUtf8().constData());
+// channel of one of our inputs ("inN") or of "system:playback_N", or -1
+static int get_port_channel(const char* const name, const char* const prefix)
+{
+    const size_t prefixLen = std::strlen(prefix);
+
+    if (std::strncmp(name, prefix, prefixLen) != 0)
+        return -1;
+
+    const int channel = std::atoi(name + prefixLen) - 1;
+
+    return (channel >= 0 && channel < int(gEngine.getChannels())) ? channel : -1;
+}
+
+// mirror new connections to the playback ports, looking only at the changed edges
+void process_connection_events()
+{
+    ConnectionEvent event;
+
+    while (gConnectionEvents.get(event))
+    {
+        ++gReconnectStats.events;
 
-            free(thisPortName);
+        // a full rescan is pending, it will see this change too
+        if (x_needReconnect)
+            continue;
+
+        jack_port_t* const source = jackbridge_port_by_id(jClient, event.source);
+        jack_port_t* const target = jackbridge_port_by_id(jClient, event.target);
+
+        // a port went away before we got here, usually a client quitting;
+        // its name may still be in gConnectedSources, so rebuild from the graph
+        if (source == nullptr || target == nullptr)
+        {
+            x_needReconnect = true;
+            continue;
         }
 
-        foreach (char* const& thisPortName, jPortList2)
+        if (jackbridge_port_is_mine(jClient, target))
         {
-            jack_port_t* const thisPort = jackbridge_port_by_name(jClient, thisPortName);
+            const int channel = get_port_channel(jackbridge_port_short_name(target), "in");
 
-            if (! (jackbridge_port_is_mine(jClient, thisPort) || jackbridge_port_connected_to(jPort2, thisPortName)))
-                jackbridge_connect(jClient, thisPortName, nameIn2.toUtf8().constData());
+            if (channel < 0)
+                continue;
 
-            free(thisPortName);
+            ++gReconnectStats.relevant;
+
+            const QString sourceName(QString::fromUtf8(jackbridge_port_name(source)));
+
+            if (event.connect)
+                gConnectedSources[channel].insert(sourceName);
+            else
+                gConnectedSources[channel].remove(sourceName);
         }
+        else if (event.connect && ! jackbridge_port_is_mine(jClient, source))
+        {
+            const int channel = get_port_channel(jackbridge_port_name(target), "system:playback_");
+
+            if (channel < 0)
+                continue;
+
+            ++gReconnectStats.relevant;
+
+            const QString sourceName(QString::fromUtf8(jackbridge_port_name(source)));
 
-        jPortList1.clear();
-        jPortList2.clear();
+            if (gConnectedSources[channel].contains(sourceName))
+                continue;
+
+            ++gReconnectStats.jackCalls;
+
+            jackbridge_connect(jClient, sourceName.toUtf8().constData(), jackbridge_port_name(gEngine.getPort(channel)));
+            gConnectedSources[channel].insert(sourceName);
+        }
     }
+}
+
+void update_connections()
+{
+    process_connection_events();
+
+    if (x_needReconnect)
+        reconnect_ports();
+}
+
+static void show_error(const QString& text)
+{
+    if (x_headless)
+        std::fprintf(stderr, "%s\n", text.toUtf8().constData());
     else
-    {
-        if (jackbridge_port_by_name(jClient, "system:capture_1") != nullptr)
-            if (! jackbridge_port_connected_to(jPort1, "system:capture_1"))
-                jackbridge_connect(jClient, "system:capture_1", nameIn1.toUtf8().constData());
+        QMessageBox::critical(nullptr, QCoreApplication::translate("MeterW", "Error"), text);
+}
 
-        if (jackbridge_port_by_name(jClient, "system:capture_2") != nullptr)
-            if (! jackbridge_port_connected_to(jPort2, "system:capture_2"))
-                jackbridge_connect(jClient, "system:capture_2", nameIn2.toUtf8().constData());
-    }
+static void signal_handler(int)
+{
+    x_quitNow = true;
+}
+
+static QString lufs_to_string(const float value)
+{
+    if (value == LoudnessMeter::kSilence)
+        return QString("-inf");
+
+    return QString::number(value, 'f', 1);
 }
 
 // -------------------------------
 // Meter class
 
-class MeterW : public DigitalPeakMeter
+// With a level history, spectrum or goniometer the meter is placed in a
+// container window, so window properties always go to window().
+
+class MeterW : public DigitalPeakMeter,
+               public FrameScheduler::Client
 {
 public:
-    MeterW() : DigitalPeakMeter(nullptr)
+    MeterW(QWidget* const parent, LevelHistory* const history, SpectrumView* const spectrum, Goniometer* const goniometer)
+        : DigitalPeakMeter(parent),
+          m_history(history),
+          m_spectrum(spectrum),
+          m_goniometer(goniometer)
     {
-        setWindowFlags(Qt::Tool | Qt::WindowStaysOnTopHint);
-        setWindowTitle(gClientName);
+        window()->setWindowFlags(Qt::Tool | Qt::WindowStaysOnTopHint);
+        window()->setWindowTitle(gClientName);
 
         if (x_isOutput)
             setColor(Color::GREEN);
         else
             setColor(Color::BLUE);
 
-        setChannels(2);
+        setChannels(gEngine.getChannels());
         setOrientation(VERTICAL);
-        setSmoothRelease(1);
 
-        displayMeter(1, 0.0f);
-        displayMeter(2, 0.0f);
+        if (x_ballistics != 0)
+            setBallistics(Ballistics(x_ballistics));
+        else
+            setSmoothRelease(1);
+
+        setPeakHold(x_peakHold);
+        setDbScale(x_dbFloor);
+
+        for (uint32_t i=0; i < gEngine.getChannels(); ++i)
+            displayMeter(i+1, 0.0f);
 
-        int refresh = float(jackbridge_get_buffer_size(jClient)) / jackbridge_get_sample_rate(jClient) * 1000;
+        m_oversSeen.fill(0, int(gEngine.getChannels()));
 
-        m_peakTimerId = startTimer(refresh > 50 ? refresh : 50);
+        // ballistics run on elapsed time, the refresh rate does not depend on the buffer size
+        FrameScheduler::getInstance().subscribe(this, kPeakRefresh);
+
+        // correlation over roughly the last 300 ms
+        m_correlationDecay = std::exp(-float(jackbridge_get_buffer_size(jClient)) / (0.3f * jackbridge_get_sample_rate(jClient)));
+
+        if (x_loudness)
+            updateLoudness();
+    }
+
+    ~MeterW()
+    {
+        FrameScheduler::getInstance().unsubscribe(this);
     }
 
 protected:
-    void timerEvent(QTimerEvent* event)
+    void updateLoudness()
+    {
+        RingBuffer<float>& blocks(gEngine.getLoudnessBlocks());
+        float block;
+
+        while (blocks.get(block))
+            m_loudness.addBlock(block);
+
+        const QString toolTip(tr("Momentary: %1 LUFS\n"
+                                 "Short-term: %2 LUFS\n"
+                                 "Integrated: %3 LUFS\n"
+                                 "Loudness range: %4 LU\n"
+                                 "(double-click to reset)").arg(lufs_to_string(m_loudness.getMomentary()))
+                                                            .arg(lufs_to_string(m_loudness.getShortTerm()))
+                                                            .arg(lufs_to_string(m_loudness.getIntegrated()))
+                                                            .arg(QString::number(m_loudness.getRange(), 'f', 1)));
+
+        const QString title(QString("%1 (%2 LUFS)").arg(gClientName).arg(lufs_to_string(m_loudness.getIntegrated())));
+
+        // this runs every frame, the title goes through the window manager so only touch it on changes
+        if (toolTip != m_lastToolTip)
+        {
+            m_lastToolTip = toolTip;
+            setToolTip(toolTip);
+        }
+
+        if (title != m_lastTitle)
+        {
+            m_lastTitle = title;
+            window()->setWindowTitle(title);
+        }
+    }
+
+    void updateHistory()
+    {
+        RingBuffer<LevelRecord>& records(gEngine.getHistoryRecords());
+        LevelRecord buffer[256];
+
+        while (const uint32_t count = records.read(buffer, 256))
+            m_history->addRecords(buffer, count);
+    }
+
+    void updateSpectrum()
+    {
+        RingBuffer<float>& samples(gEngine.getSpectrumSamples());
+        float buffer[4096];
+
+        while (const uint32_t count = samples.read(buffer, 4096))
+            m_spectrum->addSamples(buffer, count);
+    }
+
+    void updateGoniometer()
+    {
+        RingBuffer<StereoSums>& sums(gEngine.getStereoSums());
+        StereoSums block;
+
+        while (sums.get(block))
+            m_correlation.addBlock(block, m_correlationDecay);
+
+        m_goniometer->setCorrelation(m_correlation.getCorrelation());
+
+        RingBuffer<GoniometerPoint>& points(gEngine.getGoniometerPoints());
+        GoniometerPoint buffer[Goniometer::kPointBudget];
+
+        // the widget keeps only the newest points, skip what it would drop
+        const uint32_t available = points.getReadSpace();
+
+        for (uint32_t i = available; i > uint32_t(Goniometer::kPointBudget); --i)
+            points.get(buffer[0]);
+
+        if (const uint32_t count = points.read(buffer, Goniometer::kPointBudget))
+            m_goniometer->addPoints(buffer, count);
+    }
+
+    void mouseDoubleClickEvent(QMouseEvent* event)
+    {
+        if (x_loudness)
+        {
+            m_loudness.reset();
+            updateLoudness();
+        }
+
+        if (x_truePeak)
+            resetTruePeaks();
+
+        DigitalPeakMeter::mouseDoubleClickEvent(event);
+    }
+
+    bool frameTick(qint64)
+    {
+        if (x_quitNow)
+        {
+            window()->close();
+            x_quitNow = false;
+            return true;
+        }
+
+        PeakHandoff& peaks(gEngine.getPeaks());
+        float levels[MeterEngine::kMaxChannels];
+
+        for (uint32_t i=0; i < peaks.getChannels(); ++i)
+            levels[i] = peaks.collect(i);
+
+        displayMeters(levels, int(peaks.getChannels()));
+
+        // the engine count restarts when a channel gets a new source
+        for (uint32_t i=0; i < gEngine.getChannels(); ++i)
+        {
+            const uint overs = gEngine.getOvers(i);
+
+            if (overs != m_oversSeen[i])
+            {
+                displayOvers(i+1, (overs > m_oversSeen[i]) ? overs - m_oversSeen[i] : overs);
+                m_oversSeen[i] = overs;
+            }
+        }
+
+        if (x_truePeak)
+        {
+            PeakHandoff& truePeaks(gEngine.getTruePeaks());
+
+            for (uint32_t i=0; i < truePeaks.getChannels(); ++i)
+                displayTruePeak(i+1, truePeaks.collect(i));
+        }
+
+        if (x_loudness)
+            updateLoudness();
+
+        if (m_history != nullptr)
+            updateHistory();
+
+        if (m_spectrum != nullptr)
+            updateSpectrum();
+
+        if (m_goniometer != nullptr)
+            updateGoniometer();
+
+        update_connections();
+        return true;
+    }
+
+private:
+    static const int kPeakRefresh = 50; // milliseconds
+
+    QVector<uint> m_oversSeen;
+    LoudnessMeter m_loudness;
+    QString m_lastTitle;
+    QString m_lastToolTip;
+    LevelHistory* const m_history;
+    SpectrumView* const m_spectrum;
+    Goniometer*   const m_goniometer;
+
+    CorrelationMeter m_correlation;
+    float m_correlationDecay;
+};
+
+// -------------------------------
+// Meter bridge class, peak levels only but for hundreds of channels
+
+class BankW : public DigitalPeakMeterBank,
+              public FrameScheduler::Client
+{
+public:
+    BankW()
+        : DigitalPeakMeterBank(nullptr)
+    {
+        setWindowFlags(Qt::Tool | Qt::WindowStaysOnTopHint);
+        setWindowTitle(gClientName);
+
+        if (x_isOutput)
+            setColor(DigitalPeakMeter::GREEN);
+        else
+            setColor(DigitalPeakMeter::BLUE);
+
+        setChannels(gEngine.getChannels());
+
+        if (x_ballistics != 0)
+            setBallistics(DigitalPeakMeter::Ballistics(x_ballistics));
+
+        setPeakHold(x_peakHold);
+        setDbScale(x_dbFloor);
+
+        FrameScheduler::getInstance().subscribe(this, kPeakRefresh);
+    }
+
+    ~BankW()
+    {
+        FrameScheduler::getInstance().unsubscribe(this);
+    }
+
+protected:
+    bool frameTick(qint64)
     {
         if (x_quitNow)
         {
             close();
             x_quitNow = false;
-            return;
+            return true;
         }
 
-        if (event->timerId() == m_peakTimerId)
+        PeakHandoff& peaks(gEngine.getPeaks());
+        float levels[MeterEngine::kMaxChannels];
+
+        for (uint32_t i=0; i < peaks.getChannels(); ++i)
+            levels[i] = peaks.collect(i);
+
+        displayMeters(levels, int(peaks.getChannels()));
+
+        update_connections();
+        return true;
+    }
+
+private:
+    static const int kPeakRefresh = 50; // milliseconds
+};
+
+// -------------------------------
+// Headless class, only keeps the connections (or daemon ports) up to date
+
+class HeadlessMeter : public QObject
+{
+public:
+    HeadlessMeter()
+        : QObject(nullptr)
+    {
+        m_timerId = startTimer(100);
+    }
+
+protected:
+    void timerEvent(QTimerEvent* event)
+    {
+        if (x_quitNow)
         {
-            displayMeter(1, x_portValue1);
-            displayMeter(2, x_portValue2);
-            x_portValue1 = 0.0;
-            x_portValue2 = 0.0;
+            QCoreApplication::quit();
+            x_quitNow = false;
+            return;
+        }
 
-            if (x_needReconnect)
-                reconnect_ports();
+        if (event->timerId() == m_timerId)
+        {
+            if (x_daemon)
+            {
+                if (gDaemon.needsScan())
+                    gDaemon.scanPorts();
+            }
+            else
+            {
+                update_connections();
+            }
         }
 
-        QWidget::timerEvent(event);
+        QObject::timerEvent(event);
+    }
+
+private:
+    int m_timerId;
+};
+
+// -------------------------------
+// Prints the process callback timings every few seconds, for '-profile'
+
+class ProfileDump : public QObject
+{
+public:
+    ProfileDump()
+        : QObject(nullptr)
+    {
+        m_timerId = gProfiler.isEnabled() ? startTimer(5000) : 0;
+    }
+
+protected:
+    void timerEvent(QTimerEvent* event)
+    {
+        if (event->timerId() == m_timerId)
+            gProfiler.dump("process");
+
+        QObject::timerEvent(event);
     }
 
 private:
-    int m_peakTimerId;
+    int m_timerId;
 };
 
 // -------------------------------
 
 int main(int argc, char* argv[])
 {
-    QApplication app(argc, argv);
-    app.setApplicationName("JackMeter");
-    app.setApplicationVersion(VERSION);
-    app.setOrganizationName("Cadence");
-    app.setWindowIcon(QIcon(":/scalable/cadence.svg"));
+    // no display on headless machines, decide before creating the application
+    for (int i=1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-headless") == 0)
+            x_headless = true;
+
+        if (std::strcmp(argv[i], "-daemon") == 0)
+            x_daemon = x_headless = true;
+    }
+
+    QScopedPointer<QCoreApplication> app(x_headless ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
+    app->setApplicationName("JackMeter");
+    app->setApplicationVersion(VERSION);
+    app->setOrganizationName("Cadence");
+
+    if (! x_headless)
+        QApplication::setWindowIcon(QIcon(":/scalable/cadence.svg"));
 
-    if (app.arguments().contains("-in"))
+    const QStringList args(app->arguments());
+
+    if (args.contains("-in"))
         x_isOutput = false;
 
+    if (args.contains("-loudness"))
+        x_loudness = true;
+
+    if (args.contains("-truepeak"))
+        x_truePeak = true;
+
+    if (args.contains("-goniometer"))
+        x_goniometer = true;
+
+    if (args.contains("-stats"))
+        x_printStats = true;
+
+    if (args.contains("-profile"))
+        x_profile = true;
+
+    if (args.contains("-bank"))
+        x_bank = true;
+
+    // in daemon mode this is the most ports metered at once
+    uint channels = x_daemon ? MeterEngine::kMaxChannels : 2;
+
+    if (args.contains("-channels"))
+    {
+        bool ok = false;
+        const int index = args.indexOf("-channels");
+
+        if (index+1 < args.count())
+            channels = args.at(index+1).toUInt(&ok);
+
+        if (! (ok && channels >= 1 && channels <= MeterEngine::kMaxChannels))
+        {
+            show_error(app->translate("MeterW", "Invalid number of channels, must be between 1 and %1").arg(MeterEngine::kMaxChannels));
+            return 1;
+        }
+    }
+
+    // headless levels are published this many times per second
+    uint rate = 30;
+
+    if (args.contains("-rate"))
+    {
+        bool ok = false;
+        const int index = args.indexOf("-rate");
+
+        if (index+1 < args.count())
+            rate = args.at(index+1).toUInt(&ok);
+
+        if (! (ok && rate >= 1 && rate <= 1000))
+        {
+            show_error(app->translate("MeterW", "Invalid update rate, must be between 1 and 1000"));
+            return 1;
+        }
+    }
+
+    // overs are runs of 'overLength' samples at or above 'overLevel' dBFS
+    float overLevel  = 0.0f;
+    uint  overLength = 3;
+
+    if (args.contains("-over"))
+    {
+        bool ok = false;
+        const int index = args.indexOf("-over");
+
+        if (index+1 < args.count())
+            overLevel = args.at(index+1).toFloat(&ok);
+
+        if (! (ok && overLevel >= -20.0f && overLevel <= 0.0f))
+        {
+            show_error(app->translate("MeterW", "Invalid over threshold, must be between -20 and 0 dBFS"));
+            return 1;
+        }
+    }
+
+    if (args.contains("-overlength"))
+    {
+        bool ok = false;
+        const int index = args.indexOf("-overlength");
+
+        if (index+1 < args.count())
+            overLength = args.at(index+1).toUInt(&ok);
+
+        if (! (ok && overLength >= 1 && overLength <= 100))
+        {
+            show_error(app->translate("MeterW", "Invalid over length, must be between 1 and 100 samples"));
+            return 1;
+        }
+    }
+
+    if (args.contains("-ballistics"))
+    {
+        const int index = args.indexOf("-ballistics");
+        const QString mode((index+1 < args.count()) ? args.at(index+1) : QString());
+
+        if (mode == "peak")
+            x_ballistics = DigitalPeakMeter::PEAK;
+        else if (mode == "ppm")
+            x_ballistics = DigitalPeakMeter::PPM;
+        else if (mode == "vu")
+            x_ballistics = DigitalPeakMeter::VU;
+        else
+        {
+            show_error(app->translate("MeterW", "Invalid ballistics, must be 'peak', 'ppm' or 'vu'"));
+            return 1;
+        }
+    }
+
+    if (args.contains("-hold"))
+    {
+        bool ok = false;
+        const int index = args.indexOf("-hold");
+
+        if (index+1 < args.count())
+            x_peakHold = args.at(index+1).toInt(&ok);
+
+        if (! (ok && x_peakHold >= 0 && x_peakHold <= 10000))
+        {
+            show_error(app->translate("MeterW", "Invalid peak hold time, must be between 0 and 10000 ms"));
+            return 1;
+        }
+    }
+
+    if (args.contains("-db"))
+    {
+        bool ok = false;
+        const int index = args.indexOf("-db");
+
+        if (index+1 < args.count())
+            x_dbFloor = args.at(index+1).toInt(&ok);
+
+        if (! (ok && x_dbFloor >= -140 && x_dbFloor <= -20))
+        {
+            show_error(app->translate("MeterW", "Invalid dB scale floor, must be between -140 and -20"));
+            return 1;
+        }
+    }
+
+    // length of the level history, 0 to disable it
+    uint historyMinutes = 0;
+
+    if (args.contains("-history"))
+    {
+        bool ok = false;
+        const int index = args.indexOf("-history");
+
+        if (index+1 < args.count())
+            historyMinutes = args.at(index+1).toUInt(&ok);
+
+        if (! (ok && historyMinutes >= 1 && historyMinutes <= 60))
+        {
+            show_error(app->translate("MeterW", "Invalid history length, must be between 1 and 60 minutes"));
+            return 1;
+        }
+    }
+
+    // FFT size of the spectrum view, 0 to disable it
+    uint spectrumSize = 0;
+
+    if (args.contains("-spectrum"))
+    {
+        bool ok = false;
+        const int index = args.indexOf("-spectrum");
+
+        if (index+1 < args.count())
+            spectrumSize = args.at(index+1).toUInt(&ok);
+
+        if (! (ok && spectrumSize >= SpectrumAnalyzer::kMinSize && spectrumSize <= SpectrumAnalyzer::kMaxSize && (spectrumSize & (spectrumSize-1)) == 0))
+        {
+            show_error(app->translate("MeterW", "Invalid FFT size, must be a power of 2 between %1 and %2").arg(SpectrumAnalyzer::kMinSize)
+                                                                                                             .arg(SpectrumAnalyzer::kMaxSize));
+            return 1;
+        }
+    }
+
+    if (x_goniometer && channels < 2)
+    {
+        show_error(app->translate("MeterW", "The goniometer needs at least 2 channels"));
+        return 1;
+    }
+
+    if (x_bank && (x_loudness || x_truePeak || x_goniometer || historyMinutes > 0 || spectrumSize > 0))
+    {
+        show_error(app->translate("MeterW", "The meter bank only shows peak levels"));
+        return 1;
+    }
+
+    if (x_daemon && (x_loudness || x_truePeak))
+    {
+        show_error(app->translate("MeterW", "Loudness and true-peak metering are not available in daemon mode"));
+        return 1;
+    }
+
+    QString shmName;
+
+    if (args.contains("-shm"))
+    {
+        const int index = args.indexOf("-shm");
+
+        if (index+1 < args.count())
+            shmName = args.at(index+1);
+    }
+
     // JACK initialization
     jack_status_t jStatus;
 #ifdef HAVE_JACKSESSION
@@ -220,42 +888,216 @@ int main(int argc, char* argv[])
 #else
     jack_options_t jOptions = static_cast<jack_options_t>(JackNoStartServer|JackUseExactName);
 #endif
-    jClient = jackbridge_client_open(x_isOutput ? "M" : "Mi", jOptions, &jStatus);
+    jClient = jackbridge_client_open(x_daemon ? "Md" : (x_isOutput ? "M" : "Mi"), jOptions, &jStatus);
 
     if (! jClient)
     {
         std::string errorString(jackbridge_status_get_error_string(jStatus));
-        QMessageBox::critical(nullptr, app.translate("MeterW", "Error"), app.translate("MeterW",
-                                                                                       "Could not connect to JACK, possible reasons:\n"
-                                                                                       "%1").arg(QString::fromStdString(errorString)));
+        show_error(app->translate("MeterW", "Could not connect to JACK, possible reasons:\n"
+                                            "%1").arg(QString::fromStdString(errorString)));
         return 1;
     }
 
     gClientName = jackbridge_get_client_name(jClient);
 
-    jPort1 = jackbridge_port_register(jClient, "in1", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-    jPort2 = jackbridge_port_register(jClient, "in2", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+    if (! (x_daemon ? gEngine.reserveSlots(jClient, channels) : gEngine.registerPorts(jClient, channels)))
+    {
+        show_error(app->translate("MeterW", "Could not register %1 JACK ports").arg(channels));
+        jackbridge_client_close(jClient);
+        return 1;
+    }
+
+    gEngine.setOverThreshold(overLevel, overLength);
+
+    if (x_headless)
+    {
+        const uint32_t sampleRate = jackbridge_get_sample_rate(jClient);
+
+        if (shmName.isEmpty())
+            shmName = x_daemon ? QString("/cadence-meters") : QString("/cadence-jackmeter-%1").arg(gClientName);
+
+        const QByteArray shmNameUtf8(shmName.toUtf8());
+        const QByteArray clientNameUtf8(gClientName.toUtf8());
+
+        if (! gSharedTable.create(shmNameUtf8.constData(), clientNameUtf8.constData(), channels, sampleRate, sampleRate/rate, overLevel, overLength))
+        {
+            if (errno == EEXIST)
+                show_error(app->translate("MeterW", "Shared memory segment '%1' is in use by another meter\n"
+                                                    "(remove /dev/shm%1 if it was left behind by one that crashed)").arg(shmName));
+            else
+                show_error(app->translate("MeterW", "Could not create shared memory segment '%1'").arg(shmName));
+            jackbridge_client_close(jClient);
+            return 1;
+        }
+
+        if (x_daemon)
+        {
+            gDaemon.init(jClient, &gEngine, &gSharedTable);
+        }
+        else
+        {
+            for (uint32_t i=0; i < channels; ++i)
+                gSharedTable.setPortName(i, jackbridge_port_name(gEngine.getPort(i)));
+        }
+
+        gEngine.enableSharedTable(&gSharedTable, sampleRate/rate);
+    }
+
+    if (x_loudness)
+        gEngine.enableLoudness(jackbridge_get_sample_rate(jClient));
+
+    if (x_truePeak)
+        gEngine.enableTruePeak();
+
+    if (historyMinutes > 0 && ! x_headless)
+        gEngine.enableHistory();
+
+    if (spectrumSize > 0 && ! x_headless)
+        gEngine.enableSpectrum();
+
+    // about one point budget per 50 ms repaint
+    if (x_goniometer && ! x_headless)
+        gEngine.enableStereoScope(jackbridge_get_sample_rate(jClient) / (Goniometer::kPointBudget * 20) + 1);
+
+    gConnectionEvents.setSize(1024);
+    gConnectedSources.resize(int(gEngine.getChannels()));
+
+    if (x_profile)
+        gProfiler.init(jClient);
+
+    jackbridge_set_process_callback(jClient, process_callback, &gEngine);
+
+    if (x_daemon)
+    {
+        jackbridge_set_port_registration_callback(jClient, port_registration_callback, nullptr);
+        jackbridge_set_port_rename_callback(jClient, port_rename_callback, nullptr);
+    }
+    else
+    {
+        jackbridge_set_port_connect_callback(jClient, port_callback, nullptr);
+    }
 
-    jackbridge_set_process_callback(jClient, process_callback, nullptr);
-    jackbridge_set_port_connect_callback(jClient, port_callback, nullptr);
 #ifdef HAVE_JACKSESSION
     jackbridge_set_session_callback(jClient, session_callback, argv[0]);
 #endif
     jackbridge_activate(jClient);
 
-    reconnect_ports();
+    if (x_daemon)
+        gDaemon.scanPorts();
+    else
+        reconnect_ports();
+
+    ProfileDump profileDump;
+    int ret;
+
+    if (x_headless)
+    {
+        std::signal(SIGINT,  signal_handler);
+        std::signal(SIGTERM, signal_handler);
+
+        if (x_daemon)
+            std::printf("Publishing levels of all output ports (up to %u) to '%s'\n", channels, shmName.toUtf8().constData());
+        else
+            std::printf("Publishing levels of %u ports to '%s'\n", channels, shmName.toUtf8().constData());
+
+        HeadlessMeter headless;
+        ret = app->exec();
+    }
+    else if (x_bank)
+    {
+        BankW bank;
+        bank.resize(bank.sizeHint());
+        bank.show();
+        bank.setAttribute(Qt::WA_QuitOnClose);
+
+        // App-Loop
+        ret = app->exec();
+    }
+    else
+    {
+        const int meterWidth = qMax(70, int(channels)*14);
 
-    // Show GUI
-    MeterW gui;
-    gui.resize(70, 600);
-    gui.show();
-    gui.setAttribute(Qt::WA_QuitOnClose);
+        // Show GUI, with the level history, spectrum and goniometer on the left if requested
+        QScopedPointer<QWidget> container((historyMinutes > 0 || spectrumSize > 0 || x_goniometer) ? new QWidget() : nullptr);
+        LevelHistory* history    = nullptr;
+        SpectrumView* spectrum   = nullptr;
+        Goniometer*   goniometer = nullptr;
 
-    // App-Loop
-    int ret = app.exec();
+        if (historyMinutes > 0)
+        {
+            // one record per cycle
+            const double recordsPerSecond = double(jackbridge_get_sample_rate(jClient)) / double(jackbridge_get_buffer_size(jClient));
+
+            history = new LevelHistory(container.data());
+            history->setCapacity(uint32_t(recordsPerSecond * 60.0 * historyMinutes), recordsPerSecond);
+        }
+
+        if (spectrumSize > 0)
+        {
+            spectrum = new SpectrumView(container.data());
+            spectrum->setFftSize(jackbridge_get_sample_rate(jClient), spectrumSize);
+        }
+
+        if (x_goniometer)
+            goniometer = new Goniometer(container.data());
+
+        MeterW gui(container.data(), history, spectrum, goniometer);
+
+        if (! container.isNull())
+        {
+            QVBoxLayout* const views = new QVBoxLayout();
+            views->setContentsMargins(0, 0, 0, 0);
+            views->setSpacing(2);
+
+            if (history != nullptr)
+                views->addWidget(history, 1);
+            if (spectrum != nullptr)
+                views->addWidget(spectrum, 1);
+            if (goniometer != nullptr)
+                views->addWidget(goniometer, 1);
+
+            QHBoxLayout* const layout = new QHBoxLayout(container.data());
+            layout->setContentsMargins(0, 0, 0, 0);
+            layout->setSpacing(2);
+            layout->addLayout(views, 1);
+            layout->addWidget(&gui);
+
+            gui.setFixedWidth(meterWidth);
+            container->resize(meterWidth + 300, 600);
+            container->show();
+            container->setAttribute(Qt::WA_QuitOnClose);
+        }
+        else
+        {
+            gui.resize(meterWidth, 600);
+            gui.show();
+            gui.setAttribute(Qt::WA_QuitOnClose);
+        }
+
+        // App-Loop
+        ret = app->exec();
+    }
 
     jackbridge_deactivate(jClient);
     jackbridge_client_close(jClient);
+    gSharedTable.close();
+
+    if (x_printStats)
+        std::printf("Connections: %u events, %u touching our ports, %u JACK connects, %u full rescans\n",
+                    gReconnectStats.events, gReconnectStats.relevant, gReconnectStats.jackCalls, gReconnectStats.rescans);
+
+    if (x_printStats && ! x_daemon)
+    {
+        std::printf("Overs (%u samples at or above %.1f dBFS):", overLength, overLevel);
+
+        for (uint32_t i=0; i < gEngine.getChannels(); ++i)
+            std::printf(" %u", gEngine.getOvers(i));
+
+        std::printf("\n");
+    }
+
+    if (x_profile)
+        gProfiler.dump("process");
 
     return ret;
 }
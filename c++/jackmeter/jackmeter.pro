@@ -15,11 +15,45 @@ VERSION  = 0.5.0
 
 SOURCES  = \
     jackmeter.cpp \
-    ../widgets/digitalpeakmeter.cpp
+    meterdaemon.cpp \
+    meterengine.cpp \
+    ../dsp/fft.cpp \
+    ../dsp/levelpyramid.cpp \
+    ../dsp/loudness.cpp \
+    ../dsp/overcount.cpp \
+    ../dsp/peakdetect.cpp \
+    ../dsp/spectrum.cpp \
+    ../dsp/stereoscope.cpp \
+    ../dsp/truepeak.cpp \
+    ../widgets/digitalpeakmeter.cpp \
+    ../widgets/digitalpeakmeterbank.cpp \
+    ../widgets/framescheduler.cpp \
+    ../widgets/goniometer.cpp \
+    ../widgets/levelhistory.cpp \
+    ../widgets/spectrumview.cpp
 
 HEADERS  = \
+    ../jack_profiler.hpp \
     ../jack_utils.hpp \
-    ../widgets/digitalpeakmeter.hpp
+    ../meter_shm.hpp \
+    ../peak_handoff.hpp \
+    ../ring_buffer.hpp \
+    ../dsp/fft.hpp \
+    ../dsp/levelpyramid.hpp \
+    ../dsp/loudness.hpp \
+    ../dsp/overcount.hpp \
+    ../dsp/peakdetect.hpp \
+    ../dsp/spectrum.hpp \
+    ../dsp/stereoscope.hpp \
+    ../dsp/truepeak.hpp \
+    ../widgets/digitalpeakmeter.hpp \
+    ../widgets/digitalpeakmeterbank.hpp \
+    ../widgets/framescheduler.hpp \
+    ../widgets/goniometer.hpp \
+    ../widgets/levelhistory.hpp \
+    ../widgets/spectrumview.hpp \
+    meterdaemon.hpp \
+    meterengine.hpp
 
 INCLUDEPATH = \
     ../widgets
@@ -0,0 +1,104 @@
+/*
+ * Simple JACK Audio Meter, daemon mode
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "meterdaemon.hpp"
+
+#include <cstdio>
+
+MeterDaemon::MeterDaemon()
+    : fClient(nullptr),
+      fEngine(nullptr),
+      fTable(nullptr),
+      fNeedsScan(false),
+      fFullReported(false),
+      fScan(0),
+      fSeen(nullptr) {}
+
+MeterDaemon::~MeterDaemon()
+{
+    delete[] fSeen;
+}
+
+void MeterDaemon::init(jack_client_t* const client, MeterEngine* const engine, MeterShm* const table)
+{
+    fClient = client;
+    fEngine = engine;
+    fTable  = table;
+    fSeen   = new uint32_t[engine->getChannels()];
+
+    for (uint32_t i=0; i < engine->getChannels(); ++i)
+        fSeen[i] = 0;
+
+    fNeedsScan = true;
+}
+
+void MeterDaemon::requestScan()
+{
+    fNeedsScan = true;
+}
+
+bool MeterDaemon::needsScan() const
+{
+    return fNeedsScan;
+}
+
+void MeterDaemon::scanPorts()
+{
+    fNeedsScan = false;
+    ++fScan;
+
+    if (const char** const ports = jackbridge_get_ports(fClient, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput))
+    {
+        for (int i=0; ports[i] != nullptr; ++i)
+        {
+            int32_t slot = fTable->findPort(ports[i]);
+
+            if (slot < 0)
+            {
+                slot = fEngine->addPort();
+
+                if (slot < 0)
+                {
+                    if (! fFullReported)
+                        std::fprintf(stderr, "All %u meter slots are in use, not metering '%s'\n", fEngine->getChannels(), ports[i]);
+
+                    fFullReported = true;
+                    continue;
+                }
+
+                fTable->setPortName(slot, ports[i]);
+                jackbridge_connect(fClient, ports[i], jackbridge_port_name(fEngine->getPort(slot)));
+            }
+
+            fSeen[slot] = fScan;
+        }
+
+        jackbridge_free(ports);
+    }
+
+    // sources that went away (or were renamed) free their slot
+    for (uint32_t i=0; i < fEngine->getChannels(); ++i)
+    {
+        if (fTable->getPortName(i)[0] == '\0' || fSeen[i] == fScan)
+            continue;
+
+        fEngine->removePort(i);
+        jackbridge_port_disconnect(fClient, fEngine->getPort(i));
+        fTable->clearPortName(i);
+        fFullReported = false;
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * Simple JACK Audio Meter, daemon mode
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __METERDAEMON_HPP__
+#define __METERDAEMON_HPP__
+
+#include "meterengine.hpp"
+
+// -------------------------------
+// Follows every audio output port of the graph, giving each one a slot of
+// the engine and an entry of the shared table (found by port name).
+// Other tools read the table instead of opening their own meter clients.
+
+class MeterDaemon
+{
+public:
+    MeterDaemon();
+    ~MeterDaemon();
+
+    // not realtime safe, call before activating the client
+    void init(jack_client_t* client, MeterEngine* engine, MeterShm* table);
+
+    // JACK notification thread
+    void requestScan();
+
+    // main thread
+    bool needsScan() const;
+    void scanPorts();
+
+private:
+    jack_client_t* fClient;
+    MeterEngine*   fEngine;
+    MeterShm*      fTable;
+
+    std::atomic<bool> fNeedsScan;
+    bool fFullReported;
+
+    // number of the last scan that found each slot's source port
+    uint32_t  fScan;
+    uint32_t* fSeen;
+};
+
+#endif // __METERDAEMON_HPP__
@@ -0,0 +1,462 @@
+/*
+ * Simple JACK Audio Meter, realtime engine
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "meterengine.hpp"
+#include "../dsp/overcount.hpp"
+#include "../dsp/peakdetect.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+MeterEngine::MeterEngine()
+    : fClient(nullptr),
+      fChannels(0),
+      fGeneration(0),
+      fPorts(nullptr),
+      fBuffers(nullptr),
+      fBlockPeaks(nullptr),
+      fSlotState(nullptr),
+      fSlotSeen(nullptr),
+      fActive(nullptr),
+      fActiveCount(0),
+      fOverThreshold(overcount_threshold(0.0f)),
+      fOverLength(3),
+      fOverRuns(nullptr),
+      fOverCounts(nullptr),
+      fLoudnessEnabled(false),
+      fTruePeakEnabled(false),
+      fHistoryEnabled(false),
+      fSpectrumEnabled(false),
+      fStereoEnabled(false),
+      fStereoStride(1),
+      fStereoPhase(0),
+      fShm(nullptr),
+      fShmUpdateFrames(0),
+      fShmFrames(0),
+      fShmPeaks(nullptr),
+      fShmSquares(nullptr),
+      fShmClips(nullptr) {}
+
+MeterEngine::~MeterEngine()
+{
+    delete[] fPorts;
+    delete[] fBuffers;
+    delete[] fBlockPeaks;
+    delete[] fSlotState;
+    delete[] fSlotSeen;
+    delete[] fActive;
+    delete[] fOverRuns;
+    delete[] fOverCounts;
+    delete[] fShmPeaks;
+    delete[] fShmSquares;
+    delete[] fShmClips;
+}
+
+bool MeterEngine::registerPorts(jack_client_t* const client, const uint32_t channels)
+{
+    if (! allocateSlots(client, channels))
+        return false;
+
+    for (uint32_t i=0; i < channels; ++i)
+    {
+        if (! registerSlot(i))
+            return false;
+
+        fSlotState[i].store(++fGeneration);
+    }
+
+    return true;
+}
+
+bool MeterEngine::reserveSlots(jack_client_t* const client, const uint32_t capacity)
+{
+    return allocateSlots(client, capacity);
+}
+
+int32_t MeterEngine::addPort()
+{
+    for (uint32_t i=0; i < fChannels; ++i)
+    {
+        if (fSlotState[i].load(std::memory_order_relaxed) != 0)
+            continue;
+
+        if (fPorts[i] == nullptr && ! registerSlot(i))
+            return -1;
+
+        // the port pointer must be visible before the JACK thread uses the slot
+        fSlotState[i].store(++fGeneration, std::memory_order_release);
+        return int32_t(i);
+    }
+
+    return -1;
+}
+
+void MeterEngine::removePort(const uint32_t slot)
+{
+    if (slot < fChannels)
+        fSlotState[slot].store(0, std::memory_order_release);
+}
+
+bool MeterEngine::allocateSlots(jack_client_t* const client, const uint32_t capacity)
+{
+    if (capacity == 0 || capacity > kMaxChannels)
+        return false;
+
+    fClient     = client;
+    fChannels   = capacity;
+    fPorts      = new jack_port_t*[capacity];
+    fBuffers    = new const float*[capacity];
+    fBlockPeaks = new float[capacity];
+    fSlotState  = new std::atomic<uint32_t>[capacity];
+    fSlotSeen   = new uint32_t[capacity];
+    fActive     = new uint32_t[capacity];
+    fOverRuns   = new uint32_t[capacity];
+    fOverCounts = new std::atomic<uint32_t>[capacity];
+
+    for (uint32_t i=0; i < capacity; ++i)
+    {
+        fPorts[i]      = nullptr;
+        fBuffers[i]    = nullptr;
+        fBlockPeaks[i] = 0.0f;
+        fSlotSeen[i]   = 0;
+        fActive[i]     = 0;
+        fOverRuns[i]   = 0;
+        fSlotState[i].store(0);
+        fOverCounts[i].store(0);
+    }
+
+    fPeaks.setChannels(capacity);
+    return true;
+}
+
+bool MeterEngine::registerSlot(const uint32_t slot)
+{
+    char portName[32];
+    std::snprintf(portName, 32, "in%u", slot+1);
+
+    fPorts[slot] = jackbridge_port_register(fClient, portName, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+
+    return (fPorts[slot] != nullptr);
+}
+
+void MeterEngine::enableLoudness(const double sampleRate)
+{
+    fLoudness.init(sampleRate, fChannels);
+    fLoudnessBlocks.setSize(64);
+    fLoudnessEnabled = true;
+}
+
+void MeterEngine::enableTruePeak()
+{
+    fTruePeak.init(fChannels);
+    fTruePeaks.setChannels(fChannels);
+    fTruePeakEnabled = true;
+}
+
+void MeterEngine::enableHistory()
+{
+    // enough for a few seconds of GUI stalls at small buffer sizes
+    fHistoryRecords.setSize(4096);
+    fHistoryEnabled = true;
+}
+
+void MeterEngine::enableSpectrum()
+{
+    // the GUI takes whole FFT frames from here, up to 32k samples
+    fSpectrumSamples.setSize(65536);
+    fSpectrumEnabled = true;
+}
+
+void MeterEngine::enableStereoScope(const uint32_t stride)
+{
+    fStereoSums.setSize(1024);
+    fGoniometerPoints.setSize(16384);
+    fStereoStride  = (stride > 0) ? stride : 1;
+    fStereoPhase   = 0;
+    fStereoEnabled = true;
+}
+
+void MeterEngine::setOverThreshold(const float dBFS, const uint32_t minLength)
+{
+    fOverThreshold = overcount_threshold(dBFS);
+    fOverLength    = (minLength > 0) ? minLength : 1;
+}
+
+void MeterEngine::enableSharedTable(MeterShm* const table, const uint32_t updateFrames)
+{
+    fShmPeaks   = new float[fChannels];
+    fShmSquares = new double[fChannels];
+    fShmClips   = new uint64_t[fChannels];
+
+    for (uint32_t i=0; i < fChannels; ++i)
+    {
+        fShmPeaks[i]   = 0.0f;
+        fShmSquares[i] = 0.0;
+        fShmClips[i]   = 0;
+    }
+
+    fShmUpdateFrames = (updateFrames > 0) ? updateFrames : 1;
+    fShmFrames = 0;
+    fShm = table;
+}
+
+uint32_t MeterEngine::getChannels() const
+{
+    return fChannels;
+}
+
+jack_port_t* MeterEngine::getPort(const uint32_t channel) const
+{
+    return (channel < fChannels) ? fPorts[channel] : nullptr;
+}
+
+PeakHandoff& MeterEngine::getPeaks()
+{
+    return fPeaks;
+}
+
+PeakHandoff& MeterEngine::getTruePeaks()
+{
+    return fTruePeaks;
+}
+
+uint32_t MeterEngine::getOvers(const uint32_t channel) const
+{
+    return (channel < fChannels) ? fOverCounts[channel].load(std::memory_order_relaxed) : 0;
+}
+
+RingBuffer<float>& MeterEngine::getLoudnessBlocks()
+{
+    return fLoudnessBlocks;
+}
+
+RingBuffer<LevelRecord>& MeterEngine::getHistoryRecords()
+{
+    return fHistoryRecords;
+}
+
+RingBuffer<float>& MeterEngine::getSpectrumSamples()
+{
+    return fSpectrumSamples;
+}
+
+RingBuffer<StereoSums>& MeterEngine::getStereoSums()
+{
+    return fStereoSums;
+}
+
+RingBuffer<GoniometerPoint>& MeterEngine::getGoniometerPoints()
+{
+    return fGoniometerPoints;
+}
+
+void MeterEngine::process(const jack_nframes_t nframes)
+{
+    // gather the used slots, so the passes below only see live buffers
+    fActiveCount = 0;
+
+    for (uint32_t i=0; i < fChannels; ++i)
+    {
+        const uint32_t state = fSlotState[i].load(std::memory_order_acquire);
+
+        if (state != fSlotSeen[i])
+        {
+            fSlotSeen[i] = state;
+            fOverRuns[i] = 0;
+            fOverCounts[i].store(0, std::memory_order_relaxed);
+
+            if (fShm != nullptr)
+            {
+                fShmPeaks[i]   = 0.0f;
+                fShmSquares[i] = 0.0;
+                fShmClips[i]   = 0;
+            }
+        }
+
+        if (state == 0)
+            continue;
+
+        fBuffers[fActiveCount] = (const float*)jackbridge_port_get_buffer(fPorts[i], nframes);
+        fActive[fActiveCount++] = i;
+    }
+
+    // block peaks stay in registers, published once per cycle
+    peakdetect_abs_max_multi(fBuffers, fActiveCount, nframes, fBlockPeaks);
+
+    for (uint32_t i=0; i < fActiveCount; ++i)
+        fPeaks.publish(fActive[i], fBlockPeaks[i]);
+
+    countOvers(nframes);
+
+    if (fShm != nullptr)
+        accumulateShm(nframes);
+
+    if (fHistoryEnabled)
+        measureHistory(nframes);
+
+    if (fSpectrumEnabled && fActiveCount > 0)
+        copySpectrum(nframes);
+
+    if (fStereoEnabled && fActiveCount >= 2)
+        measureStereo(nframes);
+
+    if (fTruePeakEnabled)
+    {
+        fTruePeak.process(fBuffers, fActive, fActiveCount, nframes, fBlockPeaks);
+
+        for (uint32_t k=0; k < fActiveCount; ++k)
+            fTruePeaks.publish(fActive[k], fBlockPeaks[k]);
+    }
+
+    if (fLoudnessEnabled)
+    {
+        float blocks[8];
+        const uint32_t count = fLoudness.process(fBuffers, fActive, fActiveCount, nframes, blocks, 8);
+
+        if (count > 0)
+            fLoudnessBlocks.write(blocks, count);
+    }
+}
+
+void MeterEngine::countOvers(const jack_nframes_t nframes)
+{
+    for (uint32_t k=0; k < fActiveCount; ++k)
+    {
+        const uint32_t i = fActive[k];
+
+        // a run can only complete in a block whose peak reaches the threshold,
+        // otherwise the whole block just ends it
+        if (fBlockPeaks[k] < fOverThreshold)
+        {
+            fOverRuns[i] = 0;
+            continue;
+        }
+
+        if (const uint32_t overs = overcount_process(fBuffers[k], nframes, fOverThreshold, fOverLength, fOverRuns[i]))
+            fOverCounts[i].store(fOverCounts[i].load(std::memory_order_relaxed) + overs, std::memory_order_relaxed);
+    }
+}
+
+void MeterEngine::accumulateShm(const jack_nframes_t nframes)
+{
+    for (uint32_t k=0; k < fActiveCount; ++k)
+    {
+        const uint32_t i = fActive[k];
+        const float* const buffer(fBuffers[k]);
+        float    squares = 0.0f;
+        uint32_t clips   = 0;
+
+        // branchless, so it vectorizes together with the sum
+        for (uint32_t j=0; j < nframes; ++j)
+        {
+            squares += buffer[j]*buffer[j];
+            clips   += (std::fabs(buffer[j]) >= 1.0f);
+        }
+
+        if (fBlockPeaks[k] > fShmPeaks[i])
+            fShmPeaks[i] = fBlockPeaks[k];
+
+        fShmSquares[i] += squares;
+        fShmClips[i]   += clips;
+    }
+
+    fShmFrames += nframes;
+
+    if (fShmFrames < fShmUpdateFrames)
+        return;
+
+    for (uint32_t k=0; k < fActiveCount; ++k)
+    {
+        const uint32_t i = fActive[k];
+
+        fShm->write(i, fShmPeaks[i], std::sqrt(float(fShmSquares[i] / fShmFrames)), fShmFrames, fShmClips[i],
+                    fOverCounts[i].load(std::memory_order_relaxed));
+
+        fShmPeaks[i]   = 0.0f;
+        fShmSquares[i] = 0.0;
+    }
+
+    fShmFrames = 0;
+}
+
+void MeterEngine::measureHistory(const jack_nframes_t nframes)
+{
+    LevelRecord record;
+    record.min = 0.0f;
+    record.max = 0.0f;
+
+    float squares = 0.0f;
+
+    for (uint32_t k=0; k < fActiveCount; ++k)
+    {
+        const float* const buffer(fBuffers[k]);
+        float min = 0.0f, max = 0.0f;
+
+        for (uint32_t j=0; j < nframes; ++j)
+        {
+            min      = std::fmin(min, buffer[j]);
+            max      = std::fmax(max, buffer[j]);
+            squares += buffer[j]*buffer[j];
+        }
+
+        record.min = std::fmin(record.min, min);
+        record.max = std::fmax(record.max, max);
+    }
+
+    record.meanSquare = (fActiveCount > 0 && nframes > 0) ? squares / float(fActiveCount * nframes) : 0.0f;
+
+    // dropped if the GUI is not keeping up, the history just misses those cycles
+    fHistoryRecords.put(record);
+}
+
+void MeterEngine::copySpectrum(const jack_nframes_t nframes)
+{
+    const float gain = 1.0f / float(fActiveCount);
+    float mix[256];
+
+    for (uint32_t offset=0; offset < nframes; offset += 256)
+    {
+        const uint32_t frames = (nframes - offset < 256) ? nframes - offset : 256;
+
+        for (uint32_t j=0; j < frames; ++j)
+            mix[j] = fBuffers[0][offset+j] * gain;
+
+        for (uint32_t k=1; k < fActiveCount; ++k)
+        {
+            const float* const buffer(fBuffers[k] + offset);
+
+            for (uint32_t j=0; j < frames; ++j)
+                mix[j] += buffer[j] * gain;
+        }
+
+        // dropped if the GUI is not keeping up, the analyzer just sees a jump
+        fSpectrumSamples.write(mix, frames);
+    }
+}
+
+void MeterEngine::measureStereo(const jack_nframes_t nframes)
+{
+    StereoSums sums;
+    stereoscope_sums(fBuffers[0], fBuffers[1], nframes, sums);
+    fStereoSums.put(sums);
+
+    // bigger cycles than this just get fewer points
+    GoniometerPoint points[512];
+    const uint32_t count = stereoscope_decimate(fBuffers[0], fBuffers[1], nframes, fStereoStride, fStereoPhase, points, 512);
+
+    fGoniometerPoints.write(points, count);
+}
@@ -0,0 +1,153 @@
+/*
+ * Simple JACK Audio Meter, realtime engine
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __METERENGINE_HPP__
+#define __METERENGINE_HPP__
+
+#include "../jackbridge/JackBridge.hpp"
+#include "../meter_shm.hpp"
+#include "../peak_handoff.hpp"
+#include "../ring_buffer.hpp"
+#include "../dsp/levelpyramid.hpp"
+#include "../dsp/loudness.hpp"
+#include "../dsp/stereoscope.hpp"
+#include "../dsp/truepeak.hpp"
+
+// -------------------------------
+// Everything that runs inside the JACK process callback.
+// Per-channel state is kept as plain arrays (structure-of-arrays), so one
+// pass per cycle meters all ports of the client.
+//
+// Channels are slots: with registerPorts() all of them are used from the
+// start, with reserveSlots() ports are added and removed later while the
+// client is running (daemon mode). A removed port stays registered and is
+// reused by the next addPort(), so the JACK thread never sees a dangling one.
+
+class MeterEngine
+{
+public:
+    static const uint32_t kMaxChannels = 256;
+
+    MeterEngine();
+    ~MeterEngine();
+
+    // not realtime safe, call before activating the client
+    bool registerPorts(jack_client_t* client, uint32_t channels);
+    bool reserveSlots(jack_client_t* client, uint32_t capacity);
+    void enableLoudness(double sampleRate);
+    void enableTruePeak();
+    void enableHistory();
+    void enableSpectrum();
+
+    // first two channels only, one goniometer point every 'stride' frames
+    void enableStereoScope(uint32_t stride);
+
+    // overs are runs of at least 'minLength' samples at or above 'dBFS',
+    // counted on every channel (0 dBFS and 3 samples unless set here)
+    void setOverThreshold(float dBFS, uint32_t minLength);
+
+    // publish peak, RMS, clip and over counts into 'table' every 'updateFrames'
+    // (rounded up to whole cycles), the table must outlive the client
+    void enableSharedTable(MeterShm* table, uint32_t updateFrames);
+
+    // not realtime safe, can be called while the client is running
+    int32_t addPort();
+    void    removePort(uint32_t slot);
+
+    uint32_t     getChannels() const;
+    jack_port_t* getPort(uint32_t channel) const;
+    PeakHandoff& getPeaks();
+    PeakHandoff& getTruePeaks();
+
+    // any thread, overs since the channel got its current source
+    uint32_t getOvers(uint32_t channel) const;
+
+    // 100 ms K-weighted mean squares, for LoudnessMeter
+    RingBuffer<float>& getLoudnessBlocks();
+
+    // one min/max/mean square record per cycle, over all channels
+    RingBuffer<LevelRecord>& getHistoryRecords();
+
+    // mono mix of all channels, analyzed by the GUI
+    RingBuffer<float>& getSpectrumSamples();
+
+    // one set of sums per cycle, and the decimated goniometer points
+    RingBuffer<StereoSums>&      getStereoSums();
+    RingBuffer<GoniometerPoint>& getGoniometerPoints();
+
+    // JACK thread
+    void process(jack_nframes_t nframes);
+
+private:
+    jack_client_t* fClient;
+    uint32_t fChannels;
+    uint32_t fGeneration;
+
+    jack_port_t**  fPorts;
+    const float**  fBuffers;
+    float*         fBlockPeaks;
+
+    // 0 while unused, otherwise changes each time the slot gets a new source
+    std::atomic<uint32_t>* fSlotState;
+    uint32_t* fSlotSeen;
+    uint32_t* fActive;
+    uint32_t  fActiveCount;
+
+    PeakHandoff fPeaks;
+
+    float     fOverThreshold;
+    uint32_t  fOverLength;
+    uint32_t* fOverRuns;
+    std::atomic<uint32_t>* fOverCounts;
+
+    bool fLoudnessEnabled;
+    LoudnessFilterBank fLoudness;
+    RingBuffer<float>  fLoudnessBlocks;
+
+    bool fTruePeakEnabled;
+    TruePeakDetector fTruePeak;
+    PeakHandoff fTruePeaks;
+
+    bool fHistoryEnabled;
+    RingBuffer<LevelRecord> fHistoryRecords;
+
+    bool fSpectrumEnabled;
+    RingBuffer<float> fSpectrumSamples;
+
+    bool     fStereoEnabled;
+    uint32_t fStereoStride;
+    uint32_t fStereoPhase;
+    RingBuffer<StereoSums>      fStereoSums;
+    RingBuffer<GoniometerPoint> fGoniometerPoints;
+
+    MeterShm* fShm;
+    uint32_t  fShmUpdateFrames;
+    uint32_t  fShmFrames;
+    float*    fShmPeaks;
+    double*   fShmSquares;
+    uint64_t* fShmClips;
+
+    bool allocateSlots(jack_client_t* client, uint32_t capacity);
+    bool registerSlot(uint32_t slot);
+    void countOvers(jack_nframes_t nframes);
+    void accumulateShm(jack_nframes_t nframes);
+    void measureHistory(jack_nframes_t nframes);
+    void copySpectrum(jack_nframes_t nframes);
+    void measureStereo(jack_nframes_t nframes);
+};
+
+#endif // __METERENGINE_HPP__
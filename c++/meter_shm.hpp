@@ -0,0 +1,500 @@
+/*
+ * Shared-memory level table, from the JACK thread to other processes
+ * Copyright (C) 2012-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __METER_SHM_HPP__
+#define __METER_SHM_HPP__
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <stdint.h>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+// Layout of the segment:
+//   MeterShmHeader, then one MeterShmEntry per channel, then the name index.
+//
+// The name index is an open-addressing table of 'indexSize' (a power of 2)
+// slots holding entry+1, probed linearly from the FNV-1a hash of the full
+// port name. Entries can be renamed while the segment is in use, so names
+// have their own sequence counter, written only by the process that owns
+// the segment, and findPort() checks the name again after reading it.
+//
+// The writer (JACK thread) updates each entry under its own sequence counter
+// (a seqlock): the counter is odd while the entry is being written, readers
+// retry if it was odd or changed while they copied the values.
+// Nobody ever waits on the writer and readers never make a syscall.
+//
+// 'version' is stored last when creating the segment, readers must check it
+// against kMeterShmVersion before trusting anything else.
+
+static const uint32_t kMeterShmVersion  = 3;
+static const uint32_t kMeterShmNameSize = 320;
+static const char     kMeterShmMagic[8] = { 'C', 'a', 'd', 'M', 'e', 't', 'e', 'r' };
+
+struct alignas(64) MeterShmHeader {
+    char     magic[8];
+    std::atomic<uint32_t> version;
+    uint32_t headerSize;
+    uint32_t entrySize;
+    uint32_t channels;
+    uint32_t sampleRate;
+    uint32_t updateFrames;
+    uint32_t indexSize;
+    float    overThreshold; // dBFS
+    uint32_t overLength;    // samples
+    char     clientName[64];
+};
+
+struct alignas(64) MeterShmEntry {
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> peak;    // float bits, highest absolute sample since the previous update
+    std::atomic<uint32_t> rms;     // float bits, over the same period
+    std::atomic<uint32_t> frames;  // length of that period
+    std::atomic<uint64_t> clips;   // samples at or above 0 dBFS, since the entry got its current port
+    std::atomic<uint32_t> overs;   // runs of 'overLength' samples at or above 'overThreshold', also a running
+                                   // total since the entry got its current port, not per period
+    std::atomic<uint64_t> updates;
+    std::atomic<uint32_t> nameSequence;
+    std::atomic<uint64_t> nameHash;
+    char portName[kMeterShmNameSize];
+};
+
+// a consistent copy of one entry
+struct MeterShmLevels {
+    float    peak;
+    float    rms;
+    uint32_t frames;
+    uint64_t clips;
+    uint32_t overs;
+    uint64_t updates;
+};
+
+static inline
+uint64_t meter_shm_hash(const char* name)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (; *name != '\0'; ++name)
+    {
+        hash ^= uint8_t(*name);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+class MeterShm
+{
+public:
+    MeterShm()
+        : fOwner(false),
+          fSize(0),
+          fHeader(nullptr),
+          fEntries(nullptr),
+          fIndex(nullptr)
+    {
+        fName[0] = '\0';
+    }
+
+    ~MeterShm()
+    {
+        close();
+    }
+
+    // not realtime safe, fails with errno set to EEXIST if the segment is in use
+    bool create(const char* name, const char* clientName, uint32_t channels, uint32_t sampleRate, uint32_t updateFrames,
+                float overThreshold, uint32_t overLength)
+    {
+        assert(fHeader == nullptr);
+
+#ifdef _WIN32
+        (void)name; (void)clientName; (void)channels; (void)sampleRate; (void)updateFrames;
+        (void)overThreshold; (void)overLength;
+        return false;
+#else
+        if (channels == 0 || std::strlen(name) >= sizeof(fName))
+            return false;
+
+        uint32_t indexSize = 1;
+
+        while (indexSize < channels*2)
+            indexSize <<= 1;
+
+        const size_t size = getSize(channels, indexSize);
+        // never take over a segment someone else may still be writing or reading
+        const int fd = ::shm_open(name, O_CREAT|O_EXCL|O_RDWR, 0644);
+
+        if (fd < 0)
+            return false;
+
+        if (::ftruncate(fd, off_t(size)) != 0)
+        {
+            ::close(fd);
+            ::shm_unlink(name);
+            return false;
+        }
+
+        void* const ptr = ::mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (ptr == MAP_FAILED)
+        {
+            ::shm_unlink(name);
+            return false;
+        }
+
+        // the JACK thread writes here every cycle, keep it out of swap
+        ::mlock(ptr, size);
+
+        std::strcpy(fName, name);
+        fOwner   = true;
+        fSize    = size;
+        fHeader  = new(ptr) MeterShmHeader;
+        fEntries = (MeterShmEntry*)(fHeader+1);
+        fIndex   = (std::atomic<uint32_t>*)(fEntries+channels);
+
+        std::memcpy(fHeader->magic, kMeterShmMagic, 8);
+        fHeader->headerSize    = sizeof(MeterShmHeader);
+        fHeader->entrySize     = sizeof(MeterShmEntry);
+        fHeader->channels      = channels;
+        fHeader->sampleRate    = sampleRate;
+        fHeader->updateFrames  = updateFrames;
+        fHeader->indexSize     = indexSize;
+        fHeader->overThreshold = overThreshold;
+        fHeader->overLength    = overLength;
+        std::strncpy(fHeader->clientName, clientName, sizeof(fHeader->clientName)-1);
+
+        for (uint32_t i=0; i < channels; ++i)
+        {
+            MeterShmEntry& entry(*new(&fEntries[i]) MeterShmEntry);
+            entry.sequence.store(0, std::memory_order_relaxed);
+            entry.peak.store(0, std::memory_order_relaxed);
+            entry.rms.store(0, std::memory_order_relaxed);
+            entry.frames.store(0, std::memory_order_relaxed);
+            entry.clips.store(0, std::memory_order_relaxed);
+            entry.overs.store(0, std::memory_order_relaxed);
+            entry.updates.store(0, std::memory_order_relaxed);
+            entry.nameSequence.store(0, std::memory_order_relaxed);
+            entry.nameHash.store(0, std::memory_order_relaxed);
+        }
+
+        for (uint32_t i=0; i < indexSize; ++i)
+            new(&fIndex[i]) std::atomic<uint32_t>(kIndexEmpty);
+
+        fHeader->version.store(kMeterShmVersion, std::memory_order_release);
+        return true;
+#endif
+    }
+
+    // not realtime safe
+    bool attach(const char* name)
+    {
+        assert(fHeader == nullptr);
+
+#ifdef _WIN32
+        (void)name;
+        return false;
+#else
+        const int fd = ::shm_open(name, O_RDONLY, 0);
+
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+
+        if (::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(MeterShmHeader))
+        {
+            ::close(fd);
+            return false;
+        }
+
+        const size_t size = size_t(st.st_size);
+        void* const ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (ptr == MAP_FAILED)
+            return false;
+
+        MeterShmHeader* const header = (MeterShmHeader*)ptr;
+
+        if (std::memcmp(header->magic, kMeterShmMagic, 8) != 0 ||
+            header->version.load(std::memory_order_acquire) != kMeterShmVersion ||
+            header->headerSize != sizeof(MeterShmHeader) ||
+            header->entrySize  != sizeof(MeterShmEntry)  ||
+            header->indexSize == 0 || (header->indexSize & (header->indexSize-1)) != 0 ||
+            size < getSize(header->channels, header->indexSize))
+        {
+            ::munmap(ptr, size);
+            return false;
+        }
+
+        fOwner   = false;
+        fSize    = size;
+        fHeader  = header;
+        fEntries = (MeterShmEntry*)(header+1);
+        fIndex   = (std::atomic<uint32_t>*)(fEntries+header->channels);
+        return true;
+#endif
+    }
+
+    // not realtime safe, removes the segment if we created it
+    void close()
+    {
+        if (fHeader == nullptr)
+            return;
+
+#ifndef _WIN32
+        ::munmap(fHeader, fSize);
+
+        if (fOwner)
+            ::shm_unlink(fName);
+#endif
+
+        fOwner   = false;
+        fSize    = 0;
+        fHeader  = nullptr;
+        fEntries = nullptr;
+        fIndex   = nullptr;
+        fName[0] = '\0';
+    }
+
+    bool isValid() const
+    {
+        return (fHeader != nullptr);
+    }
+
+    const MeterShmHeader* getHeader() const
+    {
+        return fHeader;
+    }
+
+    uint32_t getChannels() const
+    {
+        return (fHeader != nullptr) ? fHeader->channels : 0;
+    }
+
+    // owner only, not realtime safe; the name must not be in the table already
+    void setPortName(uint32_t channel, const char* portName)
+    {
+        assert(fOwner && channel < fHeader->channels);
+
+        if (fEntries[channel].portName[0] != '\0')
+            clearPortName(channel);
+
+        const uint64_t hash = meter_shm_hash(portName);
+        writeName(fEntries[channel], hash, portName);
+
+        // reuse the first deleted slot of the probe sequence, if any
+        const uint32_t mask = fHeader->indexSize-1;
+
+        for (uint32_t pos = uint32_t(hash) & mask;; pos = (pos+1) & mask)
+        {
+            const uint32_t value = fIndex[pos].load(std::memory_order_relaxed);
+
+            if (value == kIndexEmpty || value == kIndexDeleted)
+            {
+                fIndex[pos].store(channel+1, std::memory_order_release);
+                break;
+            }
+        }
+    }
+
+    // owner only, not realtime safe
+    void clearPortName(uint32_t channel)
+    {
+        assert(fOwner && channel < fHeader->channels);
+
+        MeterShmEntry& entry(fEntries[channel]);
+
+        if (entry.portName[0] == '\0')
+            return;
+
+        const uint32_t mask = fHeader->indexSize-1;
+
+        for (uint32_t pos = uint32_t(entry.nameHash.load(std::memory_order_relaxed)) & mask;; pos = (pos+1) & mask)
+        {
+            const uint32_t value = fIndex[pos].load(std::memory_order_relaxed);
+
+            if (value == kIndexEmpty)
+                break;
+
+            if (value == channel+1)
+            {
+                fIndex[pos].store(kIndexDeleted, std::memory_order_release);
+                break;
+            }
+        }
+
+        writeName(entry, 0, "");
+    }
+
+    // owner only
+    const char* getPortName(uint32_t channel) const
+    {
+        assert(channel < fHeader->channels);
+
+        return fEntries[channel].portName;
+    }
+
+    // any reader, returns the channel of 'portName' or -1
+    int32_t findPort(const char* portName) const
+    {
+        const uint64_t hash = meter_shm_hash(portName);
+        const uint32_t mask = fHeader->indexSize-1;
+        uint32_t pos = uint32_t(hash) & mask;
+
+        for (uint32_t probes=0; probes < fHeader->indexSize; ++probes, pos = (pos+1) & mask)
+        {
+            const uint32_t value = fIndex[pos].load(std::memory_order_acquire);
+
+            if (value == kIndexEmpty)
+                return -1;
+            if (value == kIndexDeleted || value > fHeader->channels)
+                continue;
+            if (nameMatches(fEntries[value-1], hash, portName))
+                return int32_t(value-1);
+        }
+
+        return -1;
+    }
+
+    // JACK thread, the only writer
+    void write(uint32_t channel, float peak, float rms, uint32_t frames, uint64_t clips, uint32_t overs)
+    {
+        assert(fOwner && channel < fHeader->channels);
+
+        MeterShmEntry& entry(fEntries[channel]);
+        const uint32_t seq = entry.sequence.load(std::memory_order_relaxed);
+
+        entry.sequence.store(seq+1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        entry.peak.store(floatToBits(peak), std::memory_order_relaxed);
+        entry.rms.store(floatToBits(rms), std::memory_order_relaxed);
+        entry.frames.store(frames, std::memory_order_relaxed);
+        entry.clips.store(clips, std::memory_order_relaxed);
+        entry.overs.store(overs, std::memory_order_relaxed);
+        entry.updates.store(entry.updates.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+
+        entry.sequence.store(seq+2, std::memory_order_release);
+    }
+
+    // any reader, returns false if the writer kept the entry busy
+    bool read(uint32_t channel, MeterShmLevels& levels) const
+    {
+        assert(channel < fHeader->channels);
+
+        const MeterShmEntry& entry(fEntries[channel]);
+
+        for (int tries=0; tries < 64; ++tries)
+        {
+            const uint32_t seq1 = entry.sequence.load(std::memory_order_acquire);
+
+            if (seq1 & 1)
+                continue;
+
+            levels.peak    = bitsToFloat(entry.peak.load(std::memory_order_relaxed));
+            levels.rms     = bitsToFloat(entry.rms.load(std::memory_order_relaxed));
+            levels.frames  = entry.frames.load(std::memory_order_relaxed);
+            levels.clips   = entry.clips.load(std::memory_order_relaxed);
+            levels.overs   = entry.overs.load(std::memory_order_relaxed);
+            levels.updates = entry.updates.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (entry.sequence.load(std::memory_order_relaxed) == seq1)
+                return true;
+        }
+
+        return false;
+    }
+
+private:
+    static const uint32_t kIndexEmpty   = 0;
+    static const uint32_t kIndexDeleted = 0xffffffff;
+
+    bool   fOwner;
+    size_t fSize;
+    char   fName[256];
+
+    MeterShmHeader* fHeader;
+    MeterShmEntry*  fEntries;
+    std::atomic<uint32_t>* fIndex;
+
+    static size_t getSize(uint32_t channels, uint32_t indexSize)
+    {
+        return sizeof(MeterShmHeader) + sizeof(MeterShmEntry) * channels + sizeof(std::atomic<uint32_t>) * indexSize;
+    }
+
+    static void writeName(MeterShmEntry& entry, uint64_t hash, const char* portName)
+    {
+        const uint32_t seq = entry.nameSequence.load(std::memory_order_relaxed);
+
+        entry.nameSequence.store(seq+1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        entry.nameHash.store(hash, std::memory_order_relaxed);
+        std::strncpy(entry.portName, portName, kMeterShmNameSize-1);
+        entry.portName[kMeterShmNameSize-1] = '\0';
+
+        entry.nameSequence.store(seq+2, std::memory_order_release);
+    }
+
+    static bool nameMatches(const MeterShmEntry& entry, uint64_t hash, const char* portName)
+    {
+        for (int tries=0; tries < 64; ++tries)
+        {
+            const uint32_t seq1 = entry.nameSequence.load(std::memory_order_acquire);
+
+            if (seq1 & 1)
+                continue;
+
+            const bool matches = (entry.nameHash.load(std::memory_order_relaxed) == hash &&
+                                  std::strncmp(entry.portName, portName, kMeterShmNameSize) == 0);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (entry.nameSequence.load(std::memory_order_relaxed) == seq1)
+                return matches;
+        }
+
+        return false;
+    }
+
+    static uint32_t floatToBits(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(float));
+        return bits;
+    }
+
+    static float bitsToFloat(uint32_t bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+};
+
+#endif // __METER_SHM_HPP__
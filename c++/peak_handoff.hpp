@@ -0,0 +1,108 @@
+/*
+ * Lock-free peak handoff, from the JACK thread to the GUI
+ * Copyright (C) 2012-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __PEAK_HANDOFF_HPP__
+#define __PEAK_HANDOFF_HPP__
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <stdint.h>
+
+// Single producer (JACK thread), single consumer (GUI thread).
+// Each channel holds the highest peak published since the last collect().
+// Peaks are non-negative floats, so their bit patterns order the same way as
+// their values and an integer compare-exchange is enough to raise them.
+// The consumer swaps the value with zero, so a peak either lands before the
+// swap (and is collected now) or after it (and is collected next time).
+
+class PeakHandoff
+{
+public:
+    PeakHandoff()
+        : fChannels(0),
+          fPeaks(nullptr) {}
+
+    ~PeakHandoff()
+    {
+        delete[] fPeaks;
+    }
+
+    // not realtime safe, call while the JACK client is not processing
+    void setChannels(uint32_t channels)
+    {
+        delete[] fPeaks;
+
+        fChannels = channels;
+        fPeaks    = (channels > 0) ? new std::atomic<uint32_t>[channels] : nullptr;
+
+        for (uint32_t i=0; i < channels; ++i)
+            fPeaks[i].store(0);
+    }
+
+    uint32_t getChannels() const
+    {
+        return fChannels;
+    }
+
+    // JACK thread
+    void publish(uint32_t channel, float peak)
+    {
+        assert(channel < fChannels);
+
+        const uint32_t bits = floatToBits(peak);
+
+        // ignore NaN, it would never be replaced by a real peak
+        if (bits > kInfinityBits)
+            return;
+
+        std::atomic<uint32_t>& target(fPeaks[channel]);
+        uint32_t current = target.load(std::memory_order_relaxed);
+
+        while (bits > current && ! target.compare_exchange_weak(current, bits, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    // GUI thread
+    float collect(uint32_t channel)
+    {
+        assert(channel < fChannels);
+
+        return bitsToFloat(fPeaks[channel].exchange(0, std::memory_order_acquire));
+    }
+
+private:
+    static const uint32_t kInfinityBits = 0x7f800000;
+
+    uint32_t fChannels;
+    std::atomic<uint32_t>* fPeaks;
+
+    static uint32_t floatToBits(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(float));
+        return bits & 0x7fffffff;
+    }
+
+    static float bitsToFloat(uint32_t bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+};
+
+#endif // __PEAK_HANDOFF_HPP__
@@ -0,0 +1,136 @@
+/*
+ * Wait-free ring buffer, from the JACK thread to the GUI
+ * Copyright (C) 2012-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __RING_BUFFER_HPP__
+#define __RING_BUFFER_HPP__
+
+#include <atomic>
+#include <stdint.h>
+
+// Single producer, single consumer, fixed capacity.
+// Neither side ever blocks or allocates; the producer drops what does not fit.
+
+template<typename T>
+class RingBuffer
+{
+public:
+    RingBuffer()
+        : fSize(0),
+          fMask(0),
+          fData(nullptr),
+          fReadPos(0),
+          fWritePos(0) {}
+
+    ~RingBuffer()
+    {
+        delete[] fData;
+    }
+
+    // not realtime safe, call while neither side is running
+    // capacity is rounded up to a power of 2
+    void setSize(uint32_t size)
+    {
+        uint32_t realSize = 1;
+
+        while (realSize < size)
+            realSize <<= 1;
+
+        delete[] fData;
+
+        fSize = realSize;
+        fMask = realSize - 1;
+        fData = new T[realSize];
+
+        fReadPos.store(0);
+        fWritePos.store(0);
+    }
+
+    uint32_t getSize() const
+    {
+        return fSize;
+    }
+
+    // producer side
+
+    uint32_t getWriteSpace() const
+    {
+        return fSize - (fWritePos.load(std::memory_order_relaxed) - fReadPos.load(std::memory_order_acquire));
+    }
+
+    bool put(const T& value)
+    {
+        return (write(&value, 1) == 1);
+    }
+
+    uint32_t write(const T* const values, uint32_t count)
+    {
+        const uint32_t writePos = fWritePos.load(std::memory_order_relaxed);
+        const uint32_t space    = fSize - (writePos - fReadPos.load(std::memory_order_acquire));
+
+        if (count > space)
+            count = space;
+
+        for (uint32_t i=0; i < count; ++i)
+            fData[(writePos + i) & fMask] = values[i];
+
+        fWritePos.store(writePos + count, std::memory_order_release);
+        return count;
+    }
+
+    // consumer side
+
+    uint32_t getReadSpace() const
+    {
+        return fWritePos.load(std::memory_order_acquire) - fReadPos.load(std::memory_order_relaxed);
+    }
+
+    bool get(T& value)
+    {
+        return (read(&value, 1) == 1);
+    }
+
+    uint32_t read(T* const values, uint32_t count)
+    {
+        const uint32_t readPos = fReadPos.load(std::memory_order_relaxed);
+        const uint32_t space   = fWritePos.load(std::memory_order_acquire) - readPos;
+
+        if (count > space)
+            count = space;
+
+        for (uint32_t i=0; i < count; ++i)
+            values[i] = fData[(readPos + i) & fMask];
+
+        fReadPos.store(readPos + count, std::memory_order_release);
+        return count;
+    }
+
+    // drop everything currently readable
+    void skip()
+    {
+        fReadPos.store(fWritePos.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    uint32_t fSize;
+    uint32_t fMask;
+    T*       fData;
+
+    std::atomic<uint32_t> fReadPos;
+    std::atomic<uint32_t> fWritePos;
+};
+
+#endif // __RING_BUFFER_HPP__
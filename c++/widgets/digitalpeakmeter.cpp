@@ -17,13 +17,19 @@
 
 #include "digitalpeakmeter.hpp"
 
+#include <cmath>
+#include <cstring>
+
+#include <QtGui/QMouseEvent>
 #include <QtGui/QPainter>
 #include <QtGui/QPaintEvent>
 
+// dB to natural log units, for level * exp(-dB * kDbToLog)
+static const float kDbToLog = 0.11512925f; // ln(10) / 20
+
 DigitalPeakMeter::DigitalPeakMeter(QWidget* parent)
     : QWidget(parent),
       fChannels(0),
-      fSmoothMultiplier(1),
       fWidth(0),
       fHeight(0),
       fSizeMeter(0),
@@ -32,19 +38,45 @@ DigitalPeakMeter::DigitalPeakMeter(QWidget* parent)
       fGradientMeter(0, 0, 1, 1),
       fColorBase(93, 231, 61),
       fColorBaseAlt(15, 110, 15, 100),
+      fAttackTime(0.0f),
+      fReleaseTime(0.0f),
+      fReleaseRate(0.0f),
+      fPeakHoldTime(0.0f),
+      fDbFloor(0.0f),
+      fFloorLevel(0.001f),
+      fScaleBase(0),
       fChannelsData(nullptr),
-      fLastValueData(nullptr)
+      fHoldData(nullptr),
+      fHoldTimeData(nullptr),
+      fTimeData(nullptr),
+      fNextData(nullptr),
+      fTruePeakData(nullptr),
+      fOversData(nullptr),
+      fPixmapsDirty(true)
 {
+    fClock.start();
+
     setChannels(0);
     setColor(GREEN);
+    setBallistics(PEAK);
 }
 
 DigitalPeakMeter::~DigitalPeakMeter()
 {
     if (fChannelsData != nullptr)
         delete[] fChannelsData;
-    if (fLastValueData != nullptr)
-        delete[] fLastValueData;
+    if (fHoldData != nullptr)
+        delete[] fHoldData;
+    if (fHoldTimeData != nullptr)
+        delete[] fHoldTimeData;
+    if (fTimeData != nullptr)
+        delete[] fTimeData;
+    if (fNextData != nullptr)
+        delete[] fNextData;
+    if (fTruePeakData != nullptr)
+        delete[] fTruePeakData;
+    if (fOversData != nullptr)
+        delete[] fOversData;
 }
 
 void DigitalPeakMeter::displayMeter(int meter, float level)
@@ -55,23 +87,178 @@ void DigitalPeakMeter::displayMeter(int meter, float level)
     if (meter <= 0 || meter > fChannels || fChannelsData == nullptr)
         return qCritical("DigitalPeakMeter::displayMeter(%i, %f) - invalid meter number", meter, level);
 
+    QRegion dirty;
+    runBallistics(meter - 1, level, fClock.nsecsElapsed(), dirty);
+
+    if (! dirty.isEmpty())
+        update(dirty);
+}
+
+void DigitalPeakMeter::displayMeters(const float* levels, int count)
+{
+    Q_ASSERT(fChannelsData != nullptr);
+    Q_ASSERT(count >= 0 && count <= fChannels);
+
+    if (count > fChannels)
+        count = fChannels;
+
+    if (count <= 0)
+        return;
+
+    // a single update covering only what moved
+    const qint64 now  = fClock.nsecsElapsed();
+    const qint64 last = fTimeData[0];
+    QRegion dirty;
+
+    for (int i=1; i < count; ++i)
+    {
+        // some channels were given levels on their own, time them one by one
+        if (fTimeData[i] != last)
+        {
+            for (int j=0; j < count; ++j)
+                runBallistics(j, levels[j], now, dirty);
+
+            if (! dirty.isEmpty())
+                update(dirty);
+            return;
+        }
+    }
+
+    float elapsed = (last < 0) ? 0.0f : float(now - last) / 1000000000.0f;
+
+    if (elapsed > 1.0f)
+        elapsed = 1.0f;
+
+    // same time step for every channel, so the coefficients are shared
+    const float attack = (fAttackTime > 0.0f) ? 1.0f - std::exp(-elapsed / fAttackTime) : 1.0f;
+    const float floorLevel = fFloorLevel;
+
+    // smoothing and clamping for all channels, without branches so it vectorizes
+    if (fReleaseTime > 0.0f || fReleaseRate <= 0.0f)
+    {
+        const float release = (fReleaseTime > 0.0f) ? 1.0f - std::exp(-elapsed / fReleaseTime) : 1.0f;
+
+        for (int i=0; i < count; ++i)
+        {
+            const float old   = fChannelsData[i];
+            const float level = levels[i];
+
+            float value = old + (level - old) * ((level > old) ? attack : release);
+
+            value = (value < floorLevel) ? 0.0f : value;
+            value = (value > 0.999f)     ? 1.0f : value;
+
+            fNextData[i] = value;
+        }
+    }
+    else
+    {
+        const float fall = std::exp(-fReleaseRate * kDbToLog * elapsed);
+
+        for (int i=0; i < count; ++i)
+        {
+            const float old   = fChannelsData[i];
+            const float level = levels[i];
+
+            // falling, the bar drops at the set rate but never below the level;
+            // rising, it moves towards the level, which is then above that drop
+            float drop = old * fall;
+            drop = (drop < level) ? level : drop;
+
+            const float rise = old + (level - old) * ((level > old) ? attack : 0.0f);
+
+            float value = (rise < drop) ? rise : drop;
+
+            value = (value < floorLevel) ? 0.0f : value;
+            value = (value > 0.999f)     ? 1.0f : value;
+
+            fNextData[i] = value;
+        }
+    }
+
+    // then what moved, with one pixel of slack for rounding
+    for (int i=0; i < count; ++i)
+    {
+        fTimeData[i] = now;
+
+        if (fNextData[i] != fChannelsData[i])
+        {
+            dirty += getMeterRect(i, fChannelsData[i], fNextData[i]).adjusted(-1, -1, 1, 1);
+            fChannelsData[i] = fNextData[i];
+        }
+
+        if (fPeakHoldTime > 0.0f)
+            runPeakHold(i, elapsed, dirty);
+    }
+
+    if (! dirty.isEmpty())
+        update(dirty);
+}
+
+void DigitalPeakMeter::displayTruePeak(int meter, float level)
+{
+    Q_ASSERT(fTruePeakData != nullptr);
+    Q_ASSERT(meter > 0 && meter <= fChannels);
+
+    if (meter <= 0 || meter > fChannels || fTruePeakData == nullptr)
+        return qCritical("DigitalPeakMeter::displayTruePeak(%i, %f) - invalid meter number", meter, level);
+
     int i = meter - 1;
 
-    if (fSmoothMultiplier > 0)
-        level = (fLastValueData[i] * fSmoothMultiplier + level) / float(fSmoothMultiplier + 1);
+    // true-peak is held until resetTruePeaks()
+    if (level > fTruePeakData[i])
+    {
+        fTruePeakData[i] = level;
+        update(getMeterRect(i, 0.0f, 1.0f));
+    }
+}
+
+void DigitalPeakMeter::resetTruePeaks()
+{
+    for (int i=0; i < fChannels; ++i)
+        fTruePeakData[i] = 0.0f;
+
+    update();
+}
+
+void DigitalPeakMeter::displayOvers(int meter, uint count)
+{
+    Q_ASSERT(fOversData != nullptr);
+    Q_ASSERT(meter > 0 && meter <= fChannels);
 
-    if (level < 0.001f)
-        level = 0.0f;
-    else if (level > 0.999f)
-        level = 1.0f;
+    if (meter <= 0 || meter > fChannels || fOversData == nullptr)
+        return qCritical("DigitalPeakMeter::displayOvers(%i, %u) - invalid meter number", meter, count);
 
-    if (fChannelsData[i] != level)
+    // latched, only resetOvers() or a click clears it
+    if (count > 0)
     {
-        fChannelsData[i] = level;
-        update();
+        fOversData[meter - 1] += count;
+        update(getMeterRect(meter - 1, 0.0f, 1.0f));
     }
+}
+
+void DigitalPeakMeter::resetOvers(int meter)
+{
+    Q_ASSERT(meter > 0 && meter <= fChannels);
+
+    if (meter <= 0 || meter > fChannels || fOversData == nullptr)
+        return qCritical("DigitalPeakMeter::resetOvers(%i) - invalid meter number", meter);
+
+    if (fOversData[meter - 1] != 0)
+    {
+        fOversData[meter - 1] = 0;
+        update(getMeterRect(meter - 1, 0.0f, 1.0f));
+    }
+}
+
+uint DigitalPeakMeter::getOvers(int meter) const
+{
+    Q_ASSERT(meter > 0 && meter <= fChannels);
 
-    fLastValueData[i] = level;
+    if (meter <= 0 || meter > fChannels || fOversData == nullptr)
+        return 0;
+
+    return fOversData[meter - 1];
 }
 
 void DigitalPeakMeter::setChannels(int channels)
@@ -85,25 +272,53 @@ void DigitalPeakMeter::setChannels(int channels)
 
     if (fChannelsData != nullptr)
         delete[] fChannelsData;
-    if (fLastValueData != nullptr)
-        delete[] fLastValueData;
+    if (fHoldData != nullptr)
+        delete[] fHoldData;
+    if (fHoldTimeData != nullptr)
+        delete[] fHoldTimeData;
+    if (fTimeData != nullptr)
+        delete[] fTimeData;
+    if (fNextData != nullptr)
+        delete[] fNextData;
+    if (fTruePeakData != nullptr)
+        delete[] fTruePeakData;
+    if (fOversData != nullptr)
+        delete[] fOversData;
 
     if (channels > 0)
     {
-        fChannelsData  = new float[channels];
-        fLastValueData = new float[channels];
+        fChannelsData = new float[channels];
+        fHoldData     = new float[channels];
+        fHoldTimeData = new float[channels];
+        fTimeData     = new qint64[channels];
+        fNextData     = new float[channels];
+        fTruePeakData = new float[channels];
+        fOversData    = new uint[channels];
 
         for (int i=0; i < channels; ++i)
         {
-            fChannelsData[i]  = 0.0f;
-            fLastValueData[i] = 0.0f;
+            fChannelsData[i] = 0.0f;
+            fHoldData[i]     = 0.0f;
+            fHoldTimeData[i] = 0.0f;
+            fTimeData[i]     = -1;
+            fNextData[i]     = 0.0f;
+            fTruePeakData[i] = 0.0f;
+            fOversData[i]    = 0;
         }
     }
     else
     {
-        fChannelsData  = nullptr;
-        fLastValueData = nullptr;
+        fChannelsData = nullptr;
+        fHoldData     = nullptr;
+        fHoldTimeData = nullptr;
+        fTimeData     = nullptr;
+        fNextData     = nullptr;
+        fTruePeakData = nullptr;
+        fOversData    = nullptr;
     }
+
+    updateSizes();
+    update();
 }
 
 void DigitalPeakMeter::setColor(Color color)
@@ -128,28 +343,33 @@ void DigitalPeakMeter::setOrientation(Orientation orientation)
 {
     fOrientation = orientation;
 
+    // colors follow the level, wherever the scale puts it
+    const float yellow = getScalePosition(0.8f);
+    const float base   = getScalePosition(0.6f);
+
+    QGradientStops stops;
+
     if (fOrientation == HORIZONTAL)
     {
-        fGradientMeter.setColorAt(0.0f, fColorBase);
-        fGradientMeter.setColorAt(0.2f, fColorBase);
-        fGradientMeter.setColorAt(0.4f, fColorBase);
-        fGradientMeter.setColorAt(0.6f, fColorBase);
-        fGradientMeter.setColorAt(0.8f, Qt::yellow);
-        fGradientMeter.setColorAt(1.0f, Qt::red);
+        stops << QGradientStop(0.0f, fColorBase);
+        stops << QGradientStop(base, fColorBase);
+        stops << QGradientStop(yellow, Qt::yellow);
+        stops << QGradientStop(1.0f, Qt::red);
     }
     else if (fOrientation == VERTICAL)
     {
-        fGradientMeter.setColorAt(0.0f, Qt::red);
-        fGradientMeter.setColorAt(0.2f, Qt::yellow);
-        fGradientMeter.setColorAt(0.4f, fColorBase);
-        fGradientMeter.setColorAt(0.6f, fColorBase);
-        fGradientMeter.setColorAt(0.8f, fColorBase);
-        fGradientMeter.setColorAt(1.0f, fColorBase);
+        stops << QGradientStop(0.0f, Qt::red);
+        stops << QGradientStop(1.0f - yellow, Qt::yellow);
+        stops << QGradientStop(1.0f - base, fColorBase);
+        stops << QGradientStop(1.0f, fColorBase);
     }
     else
         return qCritical("DigitalPeakMeter::setOrientation(%i) - invalid orientation", orientation);
 
+    fGradientMeter.setStops(stops);
+
     updateSizes();
+    update();
 }
 
 void DigitalPeakMeter::setSmoothRelease(int value)
@@ -161,7 +381,91 @@ void DigitalPeakMeter::setSmoothRelease(int value)
     else if (value > 5)
         value = 5;
 
-    fSmoothMultiplier = value;
+    // the fall speed 'value' used to give when called every 50 ms,
+    // where each call kept value/(value+1) of the last level
+    setBallistics(PEAK);
+
+    if (value == 0)
+        setReleaseRate(0.0f);
+    else
+        setReleaseRate(-20.0f * std::log10(float(value) / float(value + 1)) / 0.05f);
+}
+
+void DigitalPeakMeter::setBallistics(Ballistics ballistics)
+{
+    if (! getBallistics(ballistics, fAttackTime, fReleaseTime, fReleaseRate))
+        return qCritical("DigitalPeakMeter::setBallistics(%i) - invalid ballistics", ballistics);
+}
+
+bool DigitalPeakMeter::getBallistics(Ballistics ballistics, float& attackTime, float& releaseTime, float& releaseRate)
+{
+    if (ballistics == PEAK)
+    {
+        // IEC 60268-18
+        attackTime  = 0.0f;
+        releaseTime = 0.0f;
+        releaseRate = 20.0f / 1.7f;
+    }
+    else if (ballistics == PPM)
+    {
+        // IEC 60268-10 type II
+        attackTime  = 0.01f;
+        releaseTime = 0.0f;
+        releaseRate = 24.0f / 2.8f;
+    }
+    else if (ballistics == VU)
+    {
+        // a first-order approximation, 99% in 300 ms is a time constant of 300/ln(100)
+        attackTime  = 0.065f;
+        releaseTime = 0.065f;
+        releaseRate = 0.0f;
+    }
+    else
+        return false;
+
+    return true;
+}
+
+void DigitalPeakMeter::setReleaseRate(float dBPerSecond)
+{
+    Q_ASSERT(dBPerSecond >= 0.0f);
+
+    if (dBPerSecond < 0.0f)
+        return qCritical("DigitalPeakMeter::setReleaseRate(%f) - release rate must not be negative", dBPerSecond);
+
+    fReleaseTime = 0.0f;
+    fReleaseRate = dBPerSecond;
+}
+
+void DigitalPeakMeter::setPeakHold(int milliseconds)
+{
+    Q_ASSERT(milliseconds >= 0);
+
+    if (milliseconds < 0)
+        return qCritical("DigitalPeakMeter::setPeakHold(%i) - hold time must not be negative", milliseconds);
+
+    fPeakHoldTime = float(milliseconds) / 1000.0f;
+
+    for (int i=0; i < fChannels; ++i)
+    {
+        fHoldData[i]     = 0.0f;
+        fHoldTimeData[i] = 0.0f;
+    }
+
+    update();
+}
+
+void DigitalPeakMeter::setDbScale(float floor)
+{
+    Q_ASSERT(floor == 0.0f || (floor <= -20.0f && floor >= -140.0f));
+
+    if (floor != 0.0f && (floor > -20.0f || floor < -140.0f))
+        return qCritical("DigitalPeakMeter::setDbScale(%f) - floor must be between -140 and -20 dB, or 0", floor);
+
+    fDbFloor    = floor;
+    fFloorLevel = (floor < 0.0f) ? std::pow(10.0f, floor / 20.0f) : 0.001f;
+
+    setOrientation(fOrientation);
 }
 
 QSize DigitalPeakMeter::minimumSizeHint() const
@@ -179,6 +483,7 @@ void DigitalPeakMeter::updateSizes()
     fWidth  = width();
     fHeight = height();
     fSizeMeter = 0;
+    fPixmapsDirty = true;
 
     if (fOrientation == HORIZONTAL)
     {
@@ -194,90 +499,371 @@ void DigitalPeakMeter::updateSizes()
         if (fChannels > 0)
             fSizeMeter = fWidth/fChannels;
     }
+
+    updateScaleTable();
 }
 
-void DigitalPeakMeter::paintEvent(QPaintEvent* event)
+int DigitalPeakMeter::getPixels(float level) const
 {
-    QPainter painter(this);
-    event->accept();
+    const int length = (fOrientation == HORIZONTAL) ? fWidth : fHeight;
 
-    painter.setPen(Qt::black);
-    painter.setBrush(Qt::black);
-    painter.drawRect(0, 0, fWidth, fHeight);
+    if (fScaleTable.isEmpty())
+        return int(level * float(length));
 
-    int meterX = 0;
-    painter.setPen(fColorBackground);
-    painter.setBrush(fGradientMeter);
+    if (level >= 1.0f)
+        return length;
+    if (! (level > fFloorLevel))
+        return 0;
 
-    for (int i=0; i < fChannels; ++i)
+    // positive floats sort like their bits, the top ones are a coarse log2
+    uint bits;
+    std::memcpy(&bits, &level, sizeof(float));
+
+    return fScaleTable.at(int((bits >> kScaleShift) - fScaleBase));
+}
+
+float DigitalPeakMeter::getScalePosition(float level) const
+{
+    if (fDbFloor >= 0.0f)
+        return level;
+
+    if (level <= fFloorLevel)
+        return 0.0f;
+
+    return (fDbFloor - 20.0f * std::log10(level)) / fDbFloor;
+}
+
+void DigitalPeakMeter::updateScaleTable()
+{
+    const int length = (fOrientation == HORIZONTAL) ? fWidth : fHeight;
+
+    fScaleTable.clear();
+
+    if (fDbFloor >= 0.0f || length <= 0)
+        return;
+
+    uint top;
+    const float one = 1.0f;
+    std::memcpy(&top, &one, sizeof(float));
+    std::memcpy(&fScaleBase, &fFloorLevel, sizeof(float));
+
+    top        >>= kScaleShift;
+    fScaleBase >>= kScaleShift;
+
+    fScaleTable.resize(int(top - fScaleBase) + 1);
+
+    // each entry is the position of the middle of its range of levels
+    for (uint i=fScaleBase; i <= top; ++i)
     {
-        float value, level = fChannelsData[i];
+        const uint bits = (i << kScaleShift) | (1 << (kScaleShift - 1));
+        float level;
+        std::memcpy(&level, &bits, sizeof(float));
+
+        const float position = getScalePosition(level);
+        fScaleTable[int(i - fScaleBase)] = int(((position < 1.0f) ? position : 1.0f) * float(length));
+    }
+}
+
+void DigitalPeakMeter::mousePressEvent(QMouseEvent* event)
+{
+    // a click on a channel clears its over indicator
+    if (event->button() == Qt::LeftButton && fSizeMeter > 0)
+    {
+        const int pos = (fOrientation == HORIZONTAL) ? event->y() : event->x();
+        const int meter = pos / fSizeMeter + 1;
+
+        if (meter <= fChannels)
+            resetOvers(meter);
+    }
+
+    QWidget::mousePressEvent(event);
+}
+
+void DigitalPeakMeter::renderPixmaps()
+{
+    fPixmapsDirty = false;
+
+    if (fWidth <= 0 || fHeight <= 0)
+        return;
+
+    fPixmapOff = QPixmap(fWidth, fHeight);
+    fPixmapOn  = QPixmap(fWidth, fHeight);
+
+    // Off: background and scale, On: every channel at full level and scale
+    for (int on=0; on < 2; ++on)
+    {
+        QPainter painter(on ? &fPixmapOn : &fPixmapOff);
+
+        painter.setPen(Qt::black);
+        painter.setBrush(Qt::black);
+        painter.drawRect(0, 0, fWidth, fHeight);
+
+        if (on)
+        {
+            int meterX = 0;
+            painter.setPen(fColorBackground);
+            painter.setBrush(fGradientMeter);
+
+            for (int i=0; i < fChannels; ++i)
+            {
+                if (fOrientation == HORIZONTAL)
+                    painter.drawRect(0, meterX, fWidth, fSizeMeter);
+                else if (fOrientation == VERTICAL)
+                    painter.drawRect(meterX, 0, fSizeMeter, fHeight);
+
+                meterX += fSizeMeter;
+            }
+        }
 
-        if (fOrientation == HORIZONTAL)
-            value = level * float(fWidth);
-        else if (fOrientation == VERTICAL)
-            value = float(fHeight) - (level * float(fHeight));
+        painter.setBrush(Qt::black);
+
+        // Scale, fixed marks on a linear one and every 10 dB down to the floor on a dB one
+        float  tickLevels[20];
+        QColor tickColors[20];
+        int    ticks = 0;
+
+        if (fDbFloor >= 0.0f)
+        {
+            static const float kLinearTicks[] = { 0.25f, 0.50f, 0.70f, 0.83f, 0.90f, 0.96f };
+
+            for (; ticks < 6; ++ticks)
+                tickLevels[ticks] = kLinearTicks[ticks];
+        }
         else
-            value = 0.0f;
+        {
+            static const float kDbTicks[] = { -10.0f, -6.0f, -3.0f, -1.0f };
 
-        if (fOrientation == HORIZONTAL)
-            painter.drawRect(0, meterX, int(value), fSizeMeter);
-        else if (fOrientation == VERTICAL)
-            painter.drawRect(meterX, int(value), fSizeMeter, fHeight);
+            for (float db = 10.0f * std::floor(fDbFloor / 10.0f) + 10.0f; db < -10.0f; db += 10.0f)
+                tickLevels[ticks++] = std::pow(10.0f, db / 20.0f);
 
-        meterX += fSizeMeter;
+            for (int i=0; i < 4; ++i)
+                tickLevels[ticks++] = std::pow(10.0f, kDbTicks[i] / 20.0f);
+        }
+
+        // the last ones are yellow, orange and red
+        for (int i=0; i < ticks; ++i)
+            tickColors[i] = fColorBaseAlt;
+
+        tickColors[ticks-4] = tickColors[ticks-3] = QColor(110, 110, 15, 100);
+        tickColors[ticks-2] = QColor(180, 110, 15, 100);
+        tickColors[ticks-1] = QColor(110, 15, 15, 100);
+
+        const int lfull = ((fOrientation == HORIZONTAL) ? fHeight : fWidth) - 1;
+
+        for (int i=0; i < ticks; ++i)
+        {
+            const int pos = getPixels(tickLevels[i]);
+
+            painter.setPen(tickColors[i]);
+
+            if (fOrientation == HORIZONTAL)
+                painter.drawLine(pos, 2, pos, lfull-2);
+            else if (fOrientation == VERTICAL)
+                painter.drawLine(2, fHeight - pos, lfull-2, fHeight - pos);
+        }
     }
+}
+
+void DigitalPeakMeter::runBallistics(int index, float level, qint64 now, QRegion& dirty)
+{
+    // a long stall would otherwise look like one big jump
+    float elapsed = (fTimeData[index] < 0) ? 0.0f : float(now - fTimeData[index]) / 1000000000.0f;
+
+    if (elapsed > 1.0f)
+        elapsed = 1.0f;
+
+    fTimeData[index] = now;
+
+    const float last = fChannelsData[index];
+    float value;
+
+    if (level > last)
+    {
+        if (fAttackTime > 0.0f)
+            value = last + (level - last) * (1.0f - std::exp(-elapsed / fAttackTime));
+        else
+            value = level;
+    }
+    else if (fReleaseTime > 0.0f)
+    {
+        value = last + (level - last) * (1.0f - std::exp(-elapsed / fReleaseTime));
+    }
+    else if (fReleaseRate > 0.0f)
+    {
+        value = last * std::exp(-fReleaseRate * kDbToLog * elapsed);
+
+        if (value < level)
+            value = level;
+    }
+    else
+        value = level;
 
-    painter.setBrush(Qt::black);
+    if (value < fFloorLevel)
+        value = 0.0f;
+    else if (value > 0.999f)
+        value = 1.0f;
 
+    // one pixel of slack for rounding
+    if (value != last)
+    {
+        dirty += getMeterRect(index, last, value).adjusted(-1, -1, 1, 1);
+        fChannelsData[index] = value;
+    }
+
+    if (fPeakHoldTime > 0.0f)
+        runPeakHold(index, elapsed, dirty);
+}
+
+void DigitalPeakMeter::runPeakHold(int index, float elapsed, QRegion& dirty)
+{
+    const float value = fChannelsData[index];
+    const float hold  = fHoldData[index];
+
+    if (value >= hold)
+    {
+        fHoldData[index]     = value;
+        fHoldTimeData[index] = fPeakHoldTime;
+    }
+    else if ((fHoldTimeData[index] -= elapsed) <= 0.0f)
+    {
+        fHoldData[index] = value;
+    }
+
+    if (fHoldData[index] != hold)
+    {
+        dirty += getHoldRect(index, hold).adjusted(-1, -1, 1, 1);
+        dirty += getHoldRect(index, fHoldData[index]).adjusted(-1, -1, 1, 1);
+    }
+}
+
+QRect DigitalPeakMeter::getMeterRect(int index, float level1, float level2) const
+{
+    if (level1 > level2)
+        qSwap(level1, level2);
+
+    if (fOrientation == HORIZONTAL)
+    {
+        const int x1 = getPixels(level1);
+        const int x2 = getPixels(level2);
+        return QRect(x1, index * fSizeMeter, x2 - x1, fSizeMeter);
+    }
+
+    if (fOrientation == VERTICAL)
+    {
+        const int y1 = fHeight - getPixels(level2);
+        const int y2 = fHeight - getPixels(level1);
+        return QRect(index * fSizeMeter, y1, fSizeMeter, y2 - y1);
+    }
+
+    return QRect();
+}
+
+QRect DigitalPeakMeter::getHoldRect(int index, float level) const
+{
+    // a 2 pixel line just inside the end of a bar at 'level'
     if (fOrientation == HORIZONTAL)
     {
-        // Variables
-        float lsmall = fWidth;
-        float lfull  = fHeight - 1;
+        const int x = getPixels(level);
+        return QRect(x - 2, index * fSizeMeter, 2, fSizeMeter);
+    }
+
+    if (fOrientation == VERTICAL)
+    {
+        const int y = fHeight - getPixels(level);
+        return QRect(index * fSizeMeter, y, fSizeMeter, 2);
+    }
 
-        // Base
-        painter.setPen(fColorBaseAlt);
-        painter.drawLine(lsmall * 0.25f, 2, lsmall * 0.25f, lfull-2.0f);
-        painter.drawLine(lsmall * 0.50f, 2, lsmall * 0.50f, lfull-2.0f);
+    return QRect();
+}
+
+void DigitalPeakMeter::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+    event->accept();
+
+    if (fPixmapsDirty || fPixmapOff.width() != fWidth || fPixmapOff.height() != fHeight)
+        renderPixmaps();
+
+    // the static parts come from the cached pixmaps, only the dirty area is copied
+    const QRect dirty(event->rect());
 
-        // Yellow
-        painter.setPen(QColor(110, 110, 15, 100));
-        painter.drawLine(lsmall * 0.70f, 2, lsmall * 0.70f, lfull-2.0f);
-        painter.drawLine(lsmall * 0.83f, 2, lsmall * 0.83f, lfull-2.0f);
+    painter.drawPixmap(dirty, fPixmapOff, dirty);
 
-        // Orange
-        painter.setPen(QColor(180, 110, 15, 100));
-        painter.drawLine(lsmall * 0.90f, 2, lsmall * 0.90f, lfull-2.0f);
+    for (int i=0; i < fChannels; ++i)
+    {
+        const QRect lit(getMeterRect(i, 0.0f, fChannelsData[i]).intersected(dirty));
+
+        if (! lit.isEmpty())
+            painter.drawPixmap(lit, fPixmapOn, lit);
+    }
 
-        // Red
-        painter.setPen(QColor(110, 15, 15, 100));
-        painter.drawLine(lsmall * 0.96f, 2, lsmall * 0.96f, lfull-2.0f);
+    // Peak hold, a lit line where the bar was highest recently
+    for (int i=0; fPeakHoldTime > 0.0f && i < fChannels; ++i)
+    {
+        if (fHoldData[i] <= fChannelsData[i])
+            continue;
+
+        const QRect hold(getHoldRect(i, fHoldData[i]).intersected(dirty));
 
+        if (! hold.isEmpty())
+            painter.drawPixmap(hold, fPixmapOn, hold);
     }
-    else if (fOrientation == VERTICAL)
+
+    // Overs, a latched red box with the count at the loud end of each channel
+    QFont font(painter.font());
+    font.setPixelSize(9);
+    painter.setFont(font);
+
+    int meterX = 0;
+
+    for (int i=0; i < fChannels; ++i)
     {
-        // Variables
-        float lsmall = fHeight;
-        float lfull  = fWidth - 1;
+        if (fOversData[i] > 0 && getMeterRect(i, 0.0f, 1.0f).intersects(dirty))
+        {
+            const QRect rect((fOrientation == HORIZONTAL) ? QRect(fWidth - kOverBoxSize*2, meterX, kOverBoxSize*2, fSizeMeter)
+                                                          : QRect(meterX, 0, fSizeMeter, kOverBoxSize));
+
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(Qt::red);
+            painter.drawRect(rect);
+
+            painter.setPen(Qt::white);
+            painter.drawText(rect, Qt::AlignCenter, QString::number(fOversData[i]));
+        }
 
-        // Base
-        painter.setPen(fColorBaseAlt);
-        painter.drawLine(2, lsmall - (lsmall * 0.25f), lfull-2.0f, lsmall - (lsmall * 0.25f));
-        painter.drawLine(2, lsmall - (lsmall * 0.50f), lfull-2.0f, lsmall - (lsmall * 0.50f));
+        meterX += fSizeMeter;
+    }
 
-        // Yellow
-        painter.setPen(QColor(110, 110, 15, 100));
-        painter.drawLine(2, lsmall - (lsmall * 0.70f), lfull-2.0f, lsmall - (lsmall * 0.70f));
-        painter.drawLine(2, lsmall - (lsmall * 0.83f), lfull-2.0f, lsmall - (lsmall * 0.83f));
+    // True-peak, as a held marker and its dBTP value
+    meterX = 0;
+
+    for (int i=0; i < fChannels; ++i)
+    {
+        const float level = fTruePeakData[i];
+        const int   over  = (fOversData[i] == 0) ? 0 : ((fOrientation == HORIZONTAL) ? kOverBoxSize*2 : kOverBoxSize);
 
-        // Orange
-        painter.setPen(QColor(180, 110, 15, 100));
-        painter.drawLine(2, lsmall - (lsmall * 0.90f), lfull-2.0f, lsmall - (lsmall * 0.90f));
+        if (level > 0.0f && getMeterRect(i, 0.0f, 1.0f).intersects(dirty))
+        {
+            const float marker = (level > 1.0f) ? 1.0f : level;
+            const QString text(QString::number(20.0f * std::log10(level), 'f', 1));
+
+            painter.setPen(level > 1.0f ? Qt::red : Qt::white);
+
+            if (fOrientation == HORIZONTAL)
+            {
+                const int pos = qMin(getPixels(marker), fWidth - 1);
+                painter.drawLine(pos, meterX, pos, meterX + fSizeMeter - 1);
+                painter.drawText(QRect(0, meterX, fWidth - 2 - over, fSizeMeter), Qt::AlignRight | Qt::AlignVCenter, text);
+            }
+            else if (fOrientation == VERTICAL)
+            {
+                const int pos = fHeight - 1 - qMin(getPixels(marker), fHeight - 1);
+                painter.drawLine(meterX, pos, meterX + fSizeMeter - 1, pos);
+                painter.drawText(QRect(meterX, 2 + over, fSizeMeter, 12), Qt::AlignHCenter | Qt::AlignTop, text);
+            }
+        }
 
-        // Red
-        painter.setPen(QColor(110, 15, 15, 100));
-        painter.drawLine(2, lsmall - (lsmall * 0.96f), lfull-2.0f, lsmall - (lsmall * 0.96f));
+        meterX += fSizeMeter;
     }
 }
 
@@ -18,7 +18,11 @@
 #ifndef __DIGITALPEAKMETER_HPP__
 #define __DIGITALPEAKMETER_HPP__
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QTimer>
+#include <QtCore/QVector>
+#include <QtGui/QPixmap>
+#include <QtGui/QRegion>
 #include <QtWidgets/QWidget>
 
 class DigitalPeakMeter : public QWidget
@@ -34,27 +38,75 @@ public:
         BLUE  = 2
     };
 
+    // presets for attack/release, see setBallistics()
+    enum Ballistics {
+        PEAK = 1,
+        PPM  = 2,
+        VU   = 3
+    };
+
     DigitalPeakMeter(QWidget* parent);
     ~DigitalPeakMeter();
 
     void displayMeter(int meter, float level);
+    void displayMeters(const float* levels, int count); // meters 1 to 'count', one update for all
+    void displayTruePeak(int meter, float level);
+    void resetTruePeaks();
+    void displayOvers(int meter, uint count);
+    void resetOvers(int meter);
+    uint getOvers(int meter) const;
     void setChannels(int channels);
     void setColor(Color color);
     void setOrientation(Orientation orientation);
     void setSmoothRelease(int value);
 
+    // Levels move by elapsed time, not per call, so the meter looks the
+    // same at any buffer size or refresh rate.
+    // PEAK: instant attack, falls 20 dB in 1.7 s
+    // PPM:  10 ms attack, falls 24 dB in 2.8 s
+    // VU:   300 ms to 99% in both directions
+    void setBallistics(Ballistics ballistics);
+    void setReleaseRate(float dBPerSecond); // 0 to fall instantly
+    void setPeakHold(int milliseconds);     // 0 to disable
+
+    // -20 to -140 for a dB scale down to 'floor', 0 for a linear one
+    void setDbScale(float floor);
+
+    // attack/release of a preset in seconds and dB/s, false if invalid
+    static bool getBallistics(Ballistics ballistics, float& attackTime, float& releaseTime, float& releaseRate);
+
     QSize minimumSizeHint() const;
     QSize sizeHint() const;
 
 protected:
     void updateSizes();
+    void renderPixmaps();
+
+    // area of channel 'index' between two levels, for partial updates
+    QRect getMeterRect(int index, float level1, float level2) const;
+    QRect getHoldRect(int index, float level) const;
+
+    // distance of 'level' from the quiet end in pixels, and as a fraction of the length
+    int   getPixels(float level) const;
+    float getScalePosition(float level) const;
+    void  updateScaleTable();
 
+    // moves channel 'index' towards 'level', adding what changed to 'dirty'
+    void runBallistics(int index, float level, qint64 now, QRegion& dirty);
+    // the hold line of channel 'index', after its level was updated
+    void runPeakHold(int index, float elapsed, QRegion& dirty);
+
+    void mousePressEvent(QMouseEvent* event);
     void paintEvent(QPaintEvent* event);
     void resizeEvent(QResizeEvent* event);
 
 private:
+    static const int kOverBoxSize = 12;
+
+    // the dB scale table has an entry per 1/128 octave, indexed by the top float bits
+    static const uint kScaleShift = 23 - 7;
+
     int fChannels;
-    int fSmoothMultiplier;
     int fWidth, fHeight, fSizeMeter;
     Orientation fOrientation;
 
@@ -64,8 +116,30 @@ private:
     QColor fColorBase;
     QColor fColorBaseAlt;
 
-    float* fChannelsData;
-    float* fLastValueData;
+    // time constants in seconds, 0 for instant
+    float fAttackTime;
+    float fReleaseTime;
+    float fReleaseRate; // dB per second, used when fReleaseTime is 0
+    float fPeakHoldTime;
+    QElapsedTimer fClock;
+
+    float fDbFloor;
+    float fFloorLevel;  // levels below this show as nothing
+    uint  fScaleBase;   // float bits of fFloorLevel >> kScaleShift
+    QVector<int> fScaleTable;
+
+    float*  fChannelsData;
+    float*  fHoldData;
+    float*  fHoldTimeData; // seconds left before the hold drops
+    qint64* fTimeData;     // nanoseconds of the last level, -1 for none yet
+    float*  fNextData;     // displayMeters() results, before comparing
+    float*  fTruePeakData;
+    uint*   fOversData;
+
+    // static parts, rebuilt after a resize or color/orientation change
+    QPixmap fPixmapOff;
+    QPixmap fPixmapOn;
+    bool    fPixmapsDirty;
 };
 
 #endif // __DIGITALPEAKMETER_HPP__
@@ -0,0 +1,423 @@
+/*
+ * Digital Peak Meter Bank, a custom Qt4 widget
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "digitalpeakmeterbank.hpp"
+
+#include <cmath>
+#include <cstring>
+
+// -------------------------------
+
+static const float kDbToLog     = 0.11512925f; // ln(10) / 20
+static const float kDbPerOctave = 6.0205999f;  // 20 * log10(2)
+
+static const char* const kVertexShader =
+    "attribute vec2 vertex;\n"
+    "varying vec2 coord;\n"
+    "void main()\n"
+    "{\n"
+    "    coord = vertex * 0.5 + 0.5;\n"
+    "    gl_Position = vec4(vertex, 0.0, 1.0);\n"
+    "}\n";
+
+// 'across' picks the channel, 'along' runs from the quiet end to the loud one
+static const char* const kFragmentShader =
+    "#ifdef GL_ES\n"
+    "precision highp float;\n"
+    "#endif\n"
+    "uniform sampler2D levels;\n"
+    "uniform float channels;\n"
+    "uniform float vertical;\n"
+    "uniform float gap;\n"
+    "uniform float holdWidth;\n"
+    "uniform float stopBase;\n"
+    "uniform float stopYellow;\n"
+    "uniform vec4 colorBase;\n"
+    "uniform vec4 background;\n"
+    "varying vec2 coord;\n"
+    "float position(vec2 bytes)\n"
+    "{\n"
+    "    return (bytes.x * 65280.0 + bytes.y * 255.0) / 65535.0;\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "    float across = mix(1.0 - coord.y, coord.x, vertical);\n"
+    "    float along  = mix(coord.x, coord.y, vertical);\n"
+    "    float strip  = across * channels;\n"
+    "    vec4  texel  = texture2D(levels, vec2((floor(strip) + 0.5) / channels, 0.5));\n"
+    "    float level  = position(texel.rg);\n"
+    "    float hold   = position(texel.ba);\n"
+    "    vec4 color = mix(colorBase, vec4(1.0, 1.0, 0.0, 1.0), clamp((along - stopBase) / (stopYellow - stopBase), 0.0, 1.0));\n"
+    "    color = mix(color, vec4(1.0, 0.0, 0.0, 1.0), clamp((along - stopYellow) / (1.0 - stopYellow), 0.0, 1.0));\n"
+    "    float lit = max(step(along, level), step(hold - holdWidth, along) * step(along, hold) * step(level, hold));\n"
+    "    lit *= step(gap, fract(strip));\n"
+    "    gl_FragColor = mix(background, color, lit);\n"
+    "}\n";
+
+static const GLfloat kQuad[] = {
+    -1.0f, -1.0f,
+     1.0f, -1.0f,
+    -1.0f,  1.0f,
+     1.0f,  1.0f
+};
+
+// exponent plus a parabola for the mantissa, within 0.005 (0.03 dB)
+static inline float fast_log2(const float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(float));
+
+    const float exponent = float(int((bits >> 23) & 0xff) - 128);
+
+    bits = (bits & 0x007fffff) | 0x3f800000;
+
+    float mantissa;
+    std::memcpy(&mantissa, &bits, sizeof(float));
+
+    return exponent + (-0.34484843f * mantissa + 2.02466578f) * mantissa - 0.67487759f;
+}
+
+static inline void pack_position(uchar* const texel, const float position)
+{
+    const uint value = uint(position * 65535.0f + 0.5f);
+
+    texel[0] = uchar(value >> 8);
+    texel[1] = uchar(value & 0xff);
+}
+
+// -------------------------------
+
+DigitalPeakMeterBank::DigitalPeakMeterBank(QWidget* parent)
+    : QOpenGLWidget(parent),
+      fChannels(0),
+      fOrientation(DigitalPeakMeter::VERTICAL),
+      fAttackTime(0.0f),
+      fReleaseTime(0.0f),
+      fReleaseRate(0.0f),
+      fPeakHoldTime(0.0f),
+      fDbFloor(0.0f),
+      fFloorLevel(0.001f),
+      fLastTime(-1),
+      fColorBackground("#111111"),
+      fColorBase(93, 231, 61),
+      fChannelsData(nullptr),
+      fHoldData(nullptr),
+      fHoldTimeData(nullptr),
+      fTexels(nullptr),
+      fTexelsDirty(false),
+      fProgram(nullptr),
+      fTexture(0),
+      fTextureWidth(0)
+{
+    fClock.start();
+
+    setBallistics(DigitalPeakMeter::PEAK);
+}
+
+DigitalPeakMeterBank::~DigitalPeakMeterBank()
+{
+    if (fProgram != nullptr)
+    {
+        makeCurrent();
+        glDeleteTextures(1, &fTexture);
+        delete fProgram;
+        doneCurrent();
+    }
+
+    if (fChannelsData != nullptr)
+        delete[] fChannelsData;
+    if (fHoldData != nullptr)
+        delete[] fHoldData;
+    if (fHoldTimeData != nullptr)
+        delete[] fHoldTimeData;
+    if (fTexels != nullptr)
+        delete[] fTexels;
+}
+
+void DigitalPeakMeterBank::displayMeters(const float* levels, int count)
+{
+    Q_ASSERT(count >= 0 && count <= fChannels);
+
+    if (count > fChannels)
+        count = fChannels;
+
+    const qint64 now = fClock.nsecsElapsed();
+    float elapsed = (fLastTime < 0) ? 0.0f : float(now - fLastTime) / 1000000000.0f;
+
+    if (elapsed > 1.0f)
+        elapsed = 1.0f;
+
+    fLastTime = now;
+
+    // every channel moves by the same time, so the coefficients are shared
+    const float attack    = (fAttackTime > 0.0f) ? 1.0f - std::exp(-elapsed / fAttackTime) : 1.0f;
+    const bool  integrate = (fReleaseTime > 0.0f);
+    const float release   = integrate ? 1.0f - std::exp(-elapsed / fReleaseTime) : std::exp(-fReleaseRate * kDbToLog * elapsed);
+    const bool  dbScale   = (fDbFloor < 0.0f);
+    const float perOctave = dbScale ? kDbPerOctave / fDbFloor : 0.0f;
+    const float holdTime  = fPeakHoldTime;
+
+    bool changed = false;
+
+    for (int i=0; i < count; ++i)
+    {
+        const float level = levels[i];
+        const float last  = fChannelsData[i];
+
+        // instant release is a rate of 0 dB/s read as "no limit"
+        float falling = integrate ? last + (level - last) * release : ((fReleaseRate > 0.0f) ? last * release : level);
+        falling = (falling < level) ? level : falling;
+
+        float value = (level > last) ? last + (level - last) * attack : falling;
+        value = (value < fFloorLevel) ? 0.0f : value;
+        value = (value > 0.999f) ? 1.0f : value;
+
+        float hold = fHoldData[i];
+        float left = fHoldTimeData[i] - elapsed;
+
+        left = (value >= hold) ? holdTime : left;
+        hold = (value >= hold || left <= 0.0f) ? value : hold;
+        hold = (holdTime > 0.0f) ? hold : 0.0f;
+
+        changed |= (value != last || hold != fHoldData[i]);
+
+        fChannelsData[i] = value;
+        fHoldData[i]     = hold;
+        fHoldTimeData[i] = left;
+
+        float position     = dbScale ? 1.0f - fast_log2(value) * perOctave : value;
+        float holdPosition = dbScale ? 1.0f - fast_log2(hold)  * perOctave : hold;
+
+        position     = (position < 0.0f) ? 0.0f : ((position > 1.0f) ? 1.0f : position);
+        holdPosition = (holdPosition < 0.0f) ? 0.0f : ((holdPosition > 1.0f) ? 1.0f : holdPosition);
+
+        pack_position(fTexels + i*4, position);
+        pack_position(fTexels + i*4 + 2, holdPosition);
+    }
+
+    if (changed)
+    {
+        fTexelsDirty = true;
+        update();
+    }
+}
+
+void DigitalPeakMeterBank::setChannels(int channels)
+{
+    Q_ASSERT(channels >= 0);
+
+    if (channels < 0)
+        return qCritical("DigitalPeakMeterBank::setChannels(%i) - 'channels' must be a positive integer", channels);
+
+    fChannels = channels;
+
+    if (fChannelsData != nullptr)
+        delete[] fChannelsData;
+    if (fHoldData != nullptr)
+        delete[] fHoldData;
+    if (fHoldTimeData != nullptr)
+        delete[] fHoldTimeData;
+    if (fTexels != nullptr)
+        delete[] fTexels;
+
+    if (channels > 0)
+    {
+        fChannelsData = new float[channels];
+        fHoldData     = new float[channels];
+        fHoldTimeData = new float[channels];
+        fTexels       = new uchar[channels*4];
+
+        for (int i=0; i < channels; ++i)
+        {
+            fChannelsData[i] = 0.0f;
+            fHoldData[i]     = 0.0f;
+            fHoldTimeData[i] = 0.0f;
+        }
+
+        std::memset(fTexels, 0, channels*4);
+    }
+    else
+    {
+        fChannelsData = nullptr;
+        fHoldData     = nullptr;
+        fHoldTimeData = nullptr;
+        fTexels       = nullptr;
+    }
+
+    fTexelsDirty = true;
+    update();
+}
+
+void DigitalPeakMeterBank::setColor(DigitalPeakMeter::Color color)
+{
+    if (color == DigitalPeakMeter::GREEN)
+        fColorBase = QColor(93, 231, 61);
+    else if (color == DigitalPeakMeter::BLUE)
+        fColorBase = QColor(82, 238, 248);
+    else
+        return qCritical("DigitalPeakMeterBank::setColor(%i) - invalid color", color);
+
+    update();
+}
+
+void DigitalPeakMeterBank::setOrientation(DigitalPeakMeter::Orientation orientation)
+{
+    if (orientation != DigitalPeakMeter::HORIZONTAL && orientation != DigitalPeakMeter::VERTICAL)
+        return qCritical("DigitalPeakMeterBank::setOrientation(%i) - invalid orientation", orientation);
+
+    fOrientation = orientation;
+    update();
+}
+
+void DigitalPeakMeterBank::setBallistics(DigitalPeakMeter::Ballistics ballistics)
+{
+    if (! DigitalPeakMeter::getBallistics(ballistics, fAttackTime, fReleaseTime, fReleaseRate))
+        return qCritical("DigitalPeakMeterBank::setBallistics(%i) - invalid ballistics", ballistics);
+}
+
+void DigitalPeakMeterBank::setReleaseRate(float dBPerSecond)
+{
+    Q_ASSERT(dBPerSecond >= 0.0f);
+
+    if (dBPerSecond < 0.0f)
+        return qCritical("DigitalPeakMeterBank::setReleaseRate(%f) - release rate must not be negative", dBPerSecond);
+
+    fReleaseTime = 0.0f;
+    fReleaseRate = dBPerSecond;
+}
+
+void DigitalPeakMeterBank::setPeakHold(int milliseconds)
+{
+    Q_ASSERT(milliseconds >= 0);
+
+    if (milliseconds < 0)
+        return qCritical("DigitalPeakMeterBank::setPeakHold(%i) - hold time must not be negative", milliseconds);
+
+    fPeakHoldTime = float(milliseconds) / 1000.0f;
+
+    for (int i=0; i < fChannels; ++i)
+    {
+        fHoldData[i]     = 0.0f;
+        fHoldTimeData[i] = 0.0f;
+    }
+}
+
+void DigitalPeakMeterBank::setDbScale(float floor)
+{
+    Q_ASSERT(floor == 0.0f || (floor <= -20.0f && floor >= -140.0f));
+
+    if (floor != 0.0f && (floor > -20.0f || floor < -140.0f))
+        return qCritical("DigitalPeakMeterBank::setDbScale(%f) - floor must be between -140 and -20 dB, or 0", floor);
+
+    fDbFloor    = floor;
+    fFloorLevel = (floor < 0.0f) ? std::pow(10.0f, floor / 20.0f) : 0.001f;
+    update();
+}
+
+QSize DigitalPeakMeterBank::minimumSizeHint() const
+{
+    return QSize(10, 10);
+}
+
+QSize DigitalPeakMeterBank::sizeHint() const
+{
+    const int across = qMax(70, fChannels*6);
+
+    return (fOrientation == DigitalPeakMeter::HORIZONTAL) ? QSize(600, across) : QSize(across, 600);
+}
+
+float DigitalPeakMeterBank::getScalePosition(float level) const
+{
+    if (fDbFloor >= 0.0f)
+        return level;
+
+    if (level <= fFloorLevel)
+        return 0.0f;
+
+    return (fDbFloor - 20.0f * std::log10(level)) / fDbFloor;
+}
+
+void DigitalPeakMeterBank::initializeGL()
+{
+    initializeOpenGLFunctions();
+
+    fProgram = new QOpenGLShaderProgram();
+    fProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, kVertexShader);
+    fProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, kFragmentShader);
+    fProgram->bindAttributeLocation("vertex", 0);
+
+    if (! fProgram->link())
+        qCritical("DigitalPeakMeterBank::initializeGL() - shader failed to link: %s", fProgram->log().toUtf8().constData());
+
+    glGenTextures(1, &fTexture);
+    glBindTexture(GL_TEXTURE_2D, fTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    fTextureWidth = 0;
+    fTexelsDirty  = true;
+}
+
+void DigitalPeakMeterBank::paintGL()
+{
+    glClearColor(fColorBackground.redF(), fColorBackground.greenF(), fColorBackground.blueF(), 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (fChannels == 0 || ! fProgram->isLinked())
+        return;
+
+    // the only upload of the frame, a new texture only when the channel count changed
+    glBindTexture(GL_TEXTURE_2D, fTexture);
+
+    if (fTextureWidth != fChannels)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, fChannels, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, fTexels);
+        fTextureWidth = fChannels;
+    }
+    else if (fTexelsDirty)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, fChannels, 1, GL_RGBA, GL_UNSIGNED_BYTE, fTexels);
+    }
+
+    fTexelsDirty = false;
+
+    const bool  vertical = (fOrientation == DigitalPeakMeter::VERTICAL);
+    const float across   = float(vertical ? width() : height()) * devicePixelRatio();
+    const float length   = float(vertical ? height() : width()) * devicePixelRatio();
+    const float strip    = across / float(fChannels);
+
+    fProgram->bind();
+    fProgram->setUniformValue("levels", 0);
+    fProgram->setUniformValue("channels", GLfloat(fChannels));
+    fProgram->setUniformValue("vertical", vertical ? 1.0f : 0.0f);
+    fProgram->setUniformValue("gap", (strip >= 3.0f) ? 1.0f / strip : 0.0f);
+    fProgram->setUniformValue("holdWidth", 2.0f / length);
+    fProgram->setUniformValue("stopBase", getScalePosition(0.6f));
+    fProgram->setUniformValue("stopYellow", getScalePosition(0.8f));
+    fProgram->setUniformValue("colorBase", fColorBase);
+    fProgram->setUniformValue("background", fColorBackground);
+
+    fProgram->enableAttributeArray(0);
+    fProgram->setAttributeArray(0, GL_FLOAT, kQuad, 2);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    fProgram->disableAttributeArray(0);
+    fProgram->release();
+}
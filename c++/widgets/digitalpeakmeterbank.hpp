@@ -0,0 +1,88 @@
+/*
+ * Digital Peak Meter Bank, a custom Qt4 widget
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __DIGITALPEAKMETERBANK_HPP__
+#define __DIGITALPEAKMETERBANK_HPP__
+
+#include "digitalpeakmeter.hpp"
+
+#include <QtGui/QOpenGLFunctions>
+#include <QtGui/QOpenGLShaderProgram>
+#include <QtWidgets/QOpenGLWidget>
+
+// A meter bridge for many channels, drawn by OpenGL.
+// Levels go through the same ballistics and dB scale as DigitalPeakMeter,
+// but for all channels at once, and end up as one texel per channel.
+// A frame is one texture upload and one quad, the shader does the bars,
+// colors and peak hold lines, so the cost barely grows with the channels.
+
+class DigitalPeakMeterBank : public QOpenGLWidget,
+                             protected QOpenGLFunctions
+{
+public:
+    DigitalPeakMeterBank(QWidget* parent);
+    ~DigitalPeakMeterBank();
+
+    void displayMeters(const float* levels, int count); // meters 1 to 'count'
+    void setChannels(int channels);
+    void setColor(DigitalPeakMeter::Color color);
+    void setOrientation(DigitalPeakMeter::Orientation orientation);
+    void setBallistics(DigitalPeakMeter::Ballistics ballistics);
+    void setReleaseRate(float dBPerSecond); // 0 to fall instantly
+    void setPeakHold(int milliseconds);     // 0 to disable
+    void setDbScale(float floor);           // -20 to -140, 0 for linear
+
+    QSize minimumSizeHint() const;
+    QSize sizeHint() const;
+
+protected:
+    // fraction of the length for 'level', the slow version for setup
+    float getScalePosition(float level) const;
+
+    void initializeGL();
+    void paintGL();
+
+private:
+    int fChannels;
+    DigitalPeakMeter::Orientation fOrientation;
+
+    float fAttackTime;
+    float fReleaseTime;
+    float fReleaseRate;
+    float fPeakHoldTime;
+    float fDbFloor;
+    float fFloorLevel;
+    QElapsedTimer fClock;
+    qint64 fLastTime;
+
+    QColor fColorBackground;
+    QColor fColorBase;
+
+    float* fChannelsData;
+    float* fHoldData;
+    float* fHoldTimeData;
+
+    // 16-bit positions of the bar and hold line, packed as RGBA
+    uchar* fTexels;
+    bool   fTexelsDirty;
+
+    QOpenGLShaderProgram* fProgram;
+    GLuint fTexture;
+    int    fTextureWidth;
+};
+
+#endif // __DIGITALPEAKMETERBANK_HPP__
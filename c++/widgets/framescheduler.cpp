@@ -0,0 +1,156 @@
+/*
+ * Frame Scheduler, shared refresh timer for custom Qt4 widgets
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "framescheduler.hpp"
+
+#include <QtCore/QTimerEvent>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QScreen>
+
+FrameScheduler::FrameScheduler()
+    : QObject(nullptr),
+      fNextTick(0)
+{
+    fClock.start();
+}
+
+FrameScheduler& FrameScheduler::getInstance()
+{
+    static FrameScheduler instance;
+    return instance;
+}
+
+void FrameScheduler::subscribe(Client* client, int interval)
+{
+    Q_ASSERT(client != nullptr);
+    Q_ASSERT(interval >= 0);
+
+    const qint64 now = fClock.nsecsElapsed();
+
+    Subscription subscription;
+    subscription.client   = client;
+    subscription.interval = qint64(qMax(interval, 0)) * 1000000;
+    subscription.due      = now;
+
+    const int index = getIndex(client);
+
+    if (index >= 0)
+        fSubscriptions[index] = subscription;
+    else
+        fSubscriptions.append(subscription);
+
+    schedule(now);
+}
+
+void FrameScheduler::unsubscribe(Client* client)
+{
+    const int index = getIndex(client);
+
+    if (index >= 0)
+        fSubscriptions.remove(index);
+
+    if (fSubscriptions.isEmpty())
+        fTimer.stop();
+}
+
+qint64 FrameScheduler::getFramePeriod() const
+{
+    QScreen* const screen = QGuiApplication::primaryScreen();
+    qreal rate = (screen != nullptr) ? screen->refreshRate() : 0.0;
+
+    // some platforms report nothing, or nonsense
+    if (rate < 10.0 || rate > 500.0)
+        rate = 60.0;
+
+    return qint64(1000000000.0 / rate);
+}
+
+int FrameScheduler::getIndex(Client* client) const
+{
+    for (int i=0; i < fSubscriptions.count(); ++i)
+    {
+        if (fSubscriptions[i].client == client)
+            return i;
+    }
+
+    return -1;
+}
+
+void FrameScheduler::schedule(qint64 now)
+{
+    if (fSubscriptions.isEmpty())
+    {
+        fTimer.stop();
+        return;
+    }
+
+    qint64 due = fSubscriptions[0].due;
+
+    for (int i=1; i < fSubscriptions.count(); ++i)
+        due = qMin(due, fSubscriptions[i].due);
+
+    // the frame closest to when the first subscriber is due, never in the past
+    const qint64 period = getFramePeriod();
+    const qint64 frame  = qMax(((qMax(due, now) + period/2) / period) * period, now);
+
+    if (fTimer.isActive() && fNextTick <= frame)
+        return;
+
+    fNextTick = frame;
+    fTimer.start(int((frame - now + 999999) / 1000000), Qt::PreciseTimer, this);
+}
+
+void FrameScheduler::timerEvent(QTimerEvent* event)
+{
+    if (event->timerId() != fTimer.timerId())
+        return QObject::timerEvent(event);
+
+    fTimer.stop();
+
+    const qint64 now    = fClock.nsecsElapsed();
+    const qint64 period = getFramePeriod();
+
+    // clients may subscribe or unsubscribe from frameTick(), so go through a copy
+    const QVector<Subscription> subscriptions(fSubscriptions);
+
+    for (int i=0; i < subscriptions.count(); ++i)
+    {
+        const Subscription& subscription(subscriptions[i]);
+
+        if (subscription.due > now + period/2)
+            continue;
+
+        int index = getIndex(subscription.client);
+
+        if (index < 0)
+            continue;
+
+        const qint64 due = now + qMax(subscription.interval, period);
+        fSubscriptions[index].due = due;
+
+        if (subscription.client->frameTick(now))
+            continue;
+
+        // unless it subscribed again from inside frameTick()
+        index = getIndex(subscription.client);
+
+        if (index >= 0 && fSubscriptions[index].due == due)
+            fSubscriptions.remove(index);
+    }
+
+    schedule(now);
+}
@@ -0,0 +1,74 @@
+/*
+ * Frame Scheduler, shared refresh timer for custom Qt4 widgets
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __FRAMESCHEDULER_HPP__
+#define __FRAMESCHEDULER_HPP__
+
+#include <QtCore/QBasicTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <QtCore/QVector>
+
+// One timer per process for everything that redraws periodically.
+// Ticks land on a grid of the primary screen's refresh period, so the
+// updates of all subscribers go out together, at most one per displayed
+// frame each. Subscribers can ask for a longer interval, which is rounded
+// up to whole frames, and the timer only wakes for the nearest one due.
+// With nothing subscribed the timer is stopped.
+
+class FrameScheduler : public QObject
+{
+public:
+    class Client
+    {
+    public:
+        virtual ~Client() {}
+
+        // 'time' is in nanoseconds, return false to unsubscribe
+        virtual bool frameTick(qint64 time) = 0;
+    };
+
+    static FrameScheduler& getInstance();
+
+    // 'interval' in milliseconds, 0 for every frame
+    // subscribing again changes the interval and ticks on the next frame
+    void subscribe(Client* client, int interval = 0);
+    void unsubscribe(Client* client);
+
+    qint64 getFramePeriod() const; // nanoseconds
+
+protected:
+    FrameScheduler();
+
+    int  getIndex(Client* client) const;
+    void schedule(qint64 now);
+    void timerEvent(QTimerEvent* event);
+
+private:
+    struct Subscription {
+        Client* client;
+        qint64  interval; // nanoseconds
+        qint64  due;
+    };
+
+    QVector<Subscription> fSubscriptions;
+    QBasicTimer   fTimer;
+    QElapsedTimer fClock;
+    qint64        fNextTick;
+};
+
+#endif // __FRAMESCHEDULER_HPP__
@@ -0,0 +1,137 @@
+/*
+ * Goniometer, a custom Qt4 widget
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "goniometer.hpp"
+
+#include <QtGui/QPainter>
+#include <QtGui/QPaintEvent>
+
+// height of the correlation bar
+static const int kBarHeight = 14;
+
+Goniometer::Goniometer(QWidget* parent)
+    : QWidget(parent),
+      fPoints(new GoniometerPoint[kPointBudget]),
+      fScreenPoints(new QPointF[kPointBudget]),
+      fPointCount(0),
+      fPointPos(0),
+      fCorrelation(0.0f),
+      fColorBackground("#111111"),
+      fColorBase(93, 231, 61),
+      fColorBaseAlt(15, 110, 15, 100)
+{
+}
+
+Goniometer::~Goniometer()
+{
+    delete[] fPoints;
+    delete[] fScreenPoints;
+}
+
+void Goniometer::addPoints(const GoniometerPoint* points, uint32_t count)
+{
+    if (count == 0)
+        return;
+
+    // only the newest ones can be drawn anyway
+    if (count > uint32_t(kPointBudget))
+    {
+        points += count - kPointBudget;
+        count   = kPointBudget;
+    }
+
+    for (uint32_t i=0; i < count; ++i)
+    {
+        fPoints[fPointPos] = points[i];
+        fPointPos = (fPointPos + 1) % kPointBudget;
+    }
+
+    fPointCount = qMin(kPointBudget, fPointCount + int(count));
+    update();
+}
+
+void Goniometer::setCorrelation(float correlation)
+{
+    if (fCorrelation != correlation)
+    {
+        fCorrelation = correlation;
+        update();
+    }
+}
+
+QSize Goniometer::minimumSizeHint() const
+{
+    return QSize(60, 60 + kBarHeight);
+}
+
+QSize Goniometer::sizeHint() const
+{
+    return QSize(200, 200 + kBarHeight);
+}
+
+void Goniometer::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+    event->accept();
+
+    const int w = width();
+    const int h = height();
+
+    painter.fillRect(0, 0, w, h, fColorBackground);
+
+    // scope, a square centered above the bar
+    const int   size   = qMax(0, qMin(w, h - kBarHeight - 2));
+    const float radius = float(size) / 2.0f;
+    const float cx     = float(w) / 2.0f;
+    const float cy     = radius;
+
+    painter.setPen(fColorBaseAlt);
+    painter.drawLine(QPointF(cx, 0), QPointF(cx, size));                            // mono
+    painter.drawLine(QPointF(cx - radius, cy), QPointF(cx + radius, cy));           // out of phase
+    painter.drawLine(QPointF(cx - radius, 0), QPointF(cx + radius, size));          // left only
+    painter.drawLine(QPointF(cx + radius, 0), QPointF(cx - radius, size));          // right only
+
+    for (int i=0; i < fPointCount; ++i)
+    {
+        fScreenPoints[i].setX(cx + qBound(-1.0f, fPoints[i].side, 1.0f) * radius);
+        fScreenPoints[i].setY(cy - qBound(-1.0f, fPoints[i].mid,  1.0f) * radius);
+    }
+
+    painter.setPen(fColorBase);
+    painter.drawPoints(fScreenPoints, fPointCount);
+
+    // correlation, -1 on the left to +1 on the right
+    const int barY   = h - kBarHeight;
+    const int middle = w / 2;
+    const int pos    = int(float(middle) + fCorrelation * float(middle - 1));
+
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(fCorrelation < 0.0f ? QColor(Qt::red) : fColorBase);
+
+    if (pos >= middle)
+        painter.drawRect(middle, barY + 2, pos - middle, kBarHeight - 4);
+    else
+        painter.drawRect(pos, barY + 2, middle - pos, kBarHeight - 4);
+
+    painter.setPen(Qt::white);
+    painter.drawLine(middle, barY, middle, h);
+
+    QFont font(painter.font());
+    font.setPixelSize(9);
+    painter.setFont(font);
+    painter.drawText(QRect(2, barY, w - 4, kBarHeight), Qt::AlignRight | Qt::AlignVCenter, QString::number(fCorrelation, 'f', 2));
+}
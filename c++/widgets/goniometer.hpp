@@ -0,0 +1,59 @@
+/*
+ * Goniometer, a custom Qt4 widget
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __GONIOMETER_HPP__
+#define __GONIOMETER_HPP__
+
+#include "../dsp/stereoscope.hpp"
+
+#include <QtWidgets/QWidget>
+
+// Lissajous display of mid/side points plus a phase correlation bar.
+// Only the newest kPointBudget points are kept, so every repaint draws
+// the same number of points whatever the sample rate or buffer size.
+
+class Goniometer : public QWidget
+{
+public:
+    static const int kPointBudget = 2048;
+
+    Goniometer(QWidget* parent);
+    ~Goniometer();
+
+    void addPoints(const GoniometerPoint* points, uint32_t count);
+    void setCorrelation(float correlation);
+
+    QSize minimumSizeHint() const;
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent* event);
+
+private:
+    GoniometerPoint* fPoints;
+    QPointF*         fScreenPoints;
+    int fPointCount;
+    int fPointPos;
+
+    float fCorrelation;
+
+    QColor fColorBackground;
+    QColor fColorBase;
+    QColor fColorBaseAlt;
+};
+
+#endif // __GONIOMETER_HPP__
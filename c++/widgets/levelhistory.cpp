@@ -0,0 +1,145 @@
+/*
+ * Level History, a custom Qt4 widget
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "levelhistory.hpp"
+
+#include <cmath>
+
+#include <QtGui/QPainter>
+#include <QtGui/QPaintEvent>
+#include <QtGui/QWheelEvent>
+
+LevelHistory::LevelHistory(QWidget* parent)
+    : QWidget(parent),
+      fRecordsPerSecond(1.0),
+      fVisibleRecords(0),
+      fColorBackground("#111111"),
+      fColorPeak(93, 231, 61),
+      fColorRms(190, 250, 170),
+      fColorClip(Qt::red)
+{
+}
+
+void LevelHistory::setCapacity(uint32_t records, double recordsPerSecond)
+{
+    fPyramid.init(records);
+    fRecordsPerSecond = recordsPerSecond;
+    fVisibleRecords   = records;
+    update();
+}
+
+void LevelHistory::addRecords(const LevelRecord* records, uint32_t count)
+{
+    if (count == 0)
+        return;
+
+    for (uint32_t i=0; i < count; ++i)
+        fPyramid.add(records[i]);
+
+    update();
+}
+
+void LevelHistory::clear()
+{
+    fPyramid.clear();
+    update();
+}
+
+QSize LevelHistory::minimumSizeHint() const
+{
+    return QSize(40, 40);
+}
+
+QSize LevelHistory::sizeHint() const
+{
+    return QSize(300, 100);
+}
+
+void LevelHistory::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+    event->accept();
+
+    const int w = width();
+    const int h = height();
+    const float middle = float(h) / 2.0f;
+
+    painter.fillRect(0, 0, w, h, fColorBackground);
+
+    painter.setPen(QColor(15, 110, 15, 100));
+    painter.drawLine(0, int(middle), w, int(middle));
+
+    if (w <= 0 || fVisibleRecords == 0)
+        return;
+
+    const uint64_t visible = fVisibleRecords;
+    const int64_t  offset  = int64_t(fPyramid.getCount()) - int64_t(visible);
+    LevelRecord record;
+
+    // one range query per pixel column, whatever the zoom
+    for (int x=0; x < w; ++x)
+    {
+        const int64_t first = qMax(int64_t(0), offset + int64_t(visible * uint64_t(x)   / uint64_t(w)));
+        const int64_t end   =                  offset + int64_t(visible * uint64_t(x+1) / uint64_t(w));
+
+        if (end <= first || ! fPyramid.getRange(uint64_t(first), uint64_t(end - first), record))
+            continue;
+
+        const float rms  = std::sqrt(record.meanSquare);
+        const bool  clip = (record.max >= 1.0f || record.min <= -1.0f);
+
+        const int yMax = int(middle - qBound(-1.0f, record.max, 1.0f) * middle);
+        const int yMin = int(middle - qBound(-1.0f, record.min, 1.0f) * middle);
+
+        painter.setPen(clip ? fColorClip : fColorPeak);
+        painter.drawLine(x, yMax, x, yMin);
+
+        const int yRms = int(qMin(rms, 1.0f) * middle);
+
+        if (yRms > 0)
+        {
+            painter.setPen(fColorRms);
+            painter.drawLine(x, int(middle) - yRms, x, int(middle) + yRms);
+        }
+    }
+
+    // visible time span
+    QFont font(painter.font());
+    font.setPixelSize(9);
+    painter.setFont(font);
+    painter.setPen(Qt::white);
+
+    const double seconds = double(visible) / fRecordsPerSecond;
+    const QString text((seconds >= 60.0) ? QString("-%1 min").arg(seconds / 60.0, 0, 'f', 1)
+                                         : QString("-%1 s").arg(seconds, 0, 'f', 1));
+
+    painter.drawText(QRect(2, 2, w - 4, 12), Qt::AlignLeft | Qt::AlignTop, text);
+}
+
+void LevelHistory::wheelEvent(QWheelEvent* event)
+{
+    const uint64_t minimum = uint64_t(qMax(1, width()));
+    const uint64_t maximum = qMax(minimum, uint64_t(fPyramid.getCapacity()));
+
+    if (event->angleDelta().y() > 0)
+        fVisibleRecords = qMax(minimum, fVisibleRecords / 2);
+    else if (event->angleDelta().y() < 0)
+        fVisibleRecords = qMin(maximum, fVisibleRecords * 2);
+
+    event->accept();
+    update();
+}
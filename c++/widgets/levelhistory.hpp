@@ -0,0 +1,58 @@
+/*
+ * Level History, a custom Qt4 widget
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __LEVELHISTORY_HPP__
+#define __LEVELHISTORY_HPP__
+
+#include "../dsp/levelpyramid.hpp"
+
+#include <QtWidgets/QWidget>
+
+// Scrolling min/max envelope of the last minutes, newest at the right.
+// Samples reaching 0 dBFS are drawn in red, the RMS as a lighter band.
+// The mouse wheel zooms from one record per pixel up to the whole history.
+
+class LevelHistory : public QWidget
+{
+public:
+    LevelHistory(QWidget* parent);
+
+    // not realtime safe
+    void setCapacity(uint32_t records, double recordsPerSecond);
+
+    void addRecords(const LevelRecord* records, uint32_t count);
+    void clear();
+
+    QSize minimumSizeHint() const;
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent* event);
+    void wheelEvent(QWheelEvent* event);
+
+private:
+    LevelPyramid fPyramid;
+    double   fRecordsPerSecond;
+    uint64_t fVisibleRecords;
+
+    QColor fColorBackground;
+    QColor fColorPeak;
+    QColor fColorRms;
+    QColor fColorClip;
+};
+
+#endif // __LEVELHISTORY_HPP__
@@ -19,10 +19,16 @@
 
 #include <cmath>
 
-#include <QtCore/QTimer>
 #include <QtGui/QPainter>
 #include <QtGui/QPaintEvent>
 #include <QtGui/QPainterPath>
+#include <QtGui/QPixmapCache>
+
+// frames of hundreds of dials with custom paint easily go over Qt's default 10 MB
+static const int kCacheLimit = 32*1024;
+
+// seconds for a full hover fade in or out
+static const float kHoverTime = 0.2f;
 
 PixmapDial::PixmapDial(QWidget* parent)
     : QDial(parent),
@@ -32,6 +38,8 @@ PixmapDial::PixmapDial(QWidget* parent)
       fOrientation(fPixmap.width() > fPixmap.height() ? HORIZONTAL : VERTICAL),
       fHovered(false),
       fHoverStep(HOVER_MIN),
+      fHoverPosition(HOVER_MIN),
+      fHoverTime(-1),
       fLabel(""),
       fLabelPos(0.0f, 0.0f),
       fLabelWidth(0),
@@ -40,6 +48,9 @@ PixmapDial::PixmapDial(QWidget* parent)
 {
     fLabelFont.setPointSize(6);
 
+    if (QPixmapCache::cacheLimit() < kCacheLimit)
+        QPixmapCache::setCacheLimit(kCacheLimit);
+
     if (palette().window().color().lightness() > 100)
     {
         // Light background
@@ -61,6 +72,11 @@ PixmapDial::PixmapDial(QWidget* parent)
     updateSizes();
 }
 
+PixmapDial::~PixmapDial()
+{
+    FrameScheduler::getInstance().unsubscribe(this);
+}
+
 int PixmapDial::getSize() const
 {
     return fSize;
@@ -70,6 +86,7 @@ void PixmapDial::setCustomPaint(CustomPaint paint)
 {
     fCustomPaint = paint;
     fLabelPos.setY(fSize + fLabelHeight/2);
+    fLabelPixmap = QPixmap();
     update();
 }
 
@@ -82,6 +99,7 @@ void PixmapDial::setEnabled(bool enabled)
         update();
     }
     QDial::setEnabled(enabled);
+    fLabelPixmap = QPixmap();
 }
 
 void PixmapDial::setLabel(QString label)
@@ -102,6 +120,7 @@ void PixmapDial::setLabel(QString label)
     fLabelGradient.setFinalStop(0, fSize + fLabelHeight + 5);
 
     fLabelGradientRect = QRectF(float(fSize)/8.0f, float(fSize)/2.0f, float(fSize*6)/8.0f, fSize+fLabelHeight+5);
+    fLabelPixmap = QPixmap();
     update();
 }
 
@@ -153,21 +172,35 @@ void PixmapDial::updateSizes()
 
     setMinimumSize(fSize, fSize + fLabelHeight + 5);
     setMaximumSize(fSize, fSize + fLabelHeight + 5);
+
+    fLabelPixmap = QPixmap();
+}
+
+void PixmapDial::startHoverAnimation()
+{
+    // only custom paint shows the hover state, the rest just keeps it
+    if (fCustomPaint == CUSTOM_PAINT_NULL || ! isEnabled())
+    {
+        fHoverStep     = fHovered ? HOVER_MAX : HOVER_MIN;
+        fHoverPosition = fHoverStep;
+        return;
+    }
+
+    fHoverTime = -1;
+    FrameScheduler::getInstance().subscribe(this);
 }
 
 void PixmapDial::enterEvent(QEvent* event)
 {
     fHovered = true;
-    if (fHoverStep == HOVER_MIN)
-        fHoverStep = HOVER_MIN + 1;
+    startHoverAnimation();
     QDial::enterEvent(event);
 }
 
 void PixmapDial::leaveEvent(QEvent* event)
 {
     fHovered = false;
-    if (fHoverStep == HOVER_MAX)
-        fHoverStep = HOVER_MAX - 1;
+    startHoverAnimation();
     QDial::leaveEvent(event);
 }
 
@@ -176,21 +209,13 @@ void PixmapDial::paintEvent(QPaintEvent* event)
     event->accept();
 
     QPainter painter(this);
-    painter.save();
-    painter.setRenderHint(QPainter::Antialiasing, true);
 
     if (! fLabel.isEmpty())
     {
-        if (fCustomPaint == CUSTOM_PAINT_NULL)
-        {
-            painter.setPen(fColor2);
-            painter.setBrush(fLabelGradient);
-            painter.drawRect(fLabelGradientRect);
-        }
+        if (fLabelPixmap.isNull() || fLabelPixmap.devicePixelRatio() != devicePixelRatio())
+            renderLabel();
 
-        painter.setFont(fLabelFont);
-        painter.setPen(fColorT[isEnabled() ? 0 : 1]);
-        painter.drawText(fLabelPos, fLabel);
+        painter.drawPixmap(0, 0, fLabelPixmap);
     }
 
     if (isEnabled())
@@ -201,10 +226,53 @@ void PixmapDial::paintEvent(QPaintEvent* event)
         if (divider == 0.0f)
             return;
 
-        float value = current/divider;
+        painter.drawPixmap(0, 0, getFrame(current/divider));
+    }
+    else
+    {
+        painter.drawPixmap(0, 0, getFrame(0.0f));
+    }
+}
+
+QPixmap PixmapDial::getFrame(float value) const
+{
+    // custom paint is continuous, everything else can only show one of fCount frames
+    const bool custom = isEnabled() && fCustomPaint != CUSTOM_PAINT_NULL;
+    const int  step   = custom ? int(value*VALUE_STEPS + 0.5f) : int((fCount-1)*value);
+    const int  ratio  = devicePixelRatio();
+
+    const QString key(QString("PixmapDial:%1:%2:%3:%4:%5:%6:%7").arg(fPixmapNum)
+                                                                .arg(isEnabled() ? 1 : 0)
+                                                                .arg(fSize)
+                                                                .arg(ratio)
+                                                                .arg(custom ? int(fCustomPaint) : 0)
+                                                                .arg(custom ? int(fHoverStep) : 0)
+                                                                .arg(step));
+    QPixmap frame;
+
+    if (QPixmapCache::find(key, &frame))
+        return frame;
+
+    frame = QPixmap(fSize*ratio, fSize*ratio);
+    frame.setDevicePixelRatio(ratio);
+    frame.fill(Qt::transparent);
+
+    QPainter painter(&frame);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    if (! isEnabled())
+    {
+        QRectF target(0.0f, 0.0f, fSize, fSize);
+        painter.drawPixmap(target, fPixmap, target);
+    }
+    else
+    {
+        if (custom)
+            value = float(step)/float(VALUE_STEPS);
+
         QRectF source, target(0.0f, 0.0f, fSize, fSize);
 
-        int xpos, ypos, per = (fCount-1)*value;
+        int xpos, ypos, per = custom ? (fCount-1)*value : step;
 
         if (fOrientation == HORIZONTAL)
         {
@@ -295,37 +363,68 @@ void PixmapDial::paintEvent(QPaintEvent* event)
                 startAngle = 216*16;
                 spanAngle  = -252.0*16*value;
             }
-            else if (fCustomPaint == CUSTOM_PAINT_CARLA_R)
+            else
             {
                 startAngle = 324.0*16;
                 spanAngle  = 252.0*16*(1.0-value);
             }
-            else
-                return;
 
             painter.setPen(QPen(color, 2));
             painter.drawArc(3.5f, 4.5f, 22.0f, 22.0f, startAngle, spanAngle);
-
-            if (HOVER_MIN < fHoverStep && fHoverStep < HOVER_MAX)
-            {
-                fHoverStep += fHovered ? 1 : -1;
-                QTimer::singleShot(20, this, SLOT(update()));
-            }
         }
+    }
 
-        if (HOVER_MIN < fHoverStep && fHoverStep < HOVER_MAX)
-        {
-            fHoverStep += fHovered ? 1 : -1;
-            QTimer::singleShot(20, this, SLOT(update()));
-        }
+    painter.end();
+    QPixmapCache::insert(key, frame);
+
+    return frame;
+}
+
+void PixmapDial::renderLabel()
+{
+    const int ratio = devicePixelRatio();
+
+    fLabelPixmap = QPixmap(fSize*ratio, (fSize + fLabelHeight + 5)*ratio);
+    fLabelPixmap.setDevicePixelRatio(ratio);
+    fLabelPixmap.fill(Qt::transparent);
+
+    QPainter painter(&fLabelPixmap);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    if (fCustomPaint == CUSTOM_PAINT_NULL)
+    {
+        painter.setPen(fColor2);
+        painter.setBrush(fLabelGradient);
+        painter.drawRect(fLabelGradientRect);
     }
+
+    painter.setFont(fLabelFont);
+    painter.setPen(fColorT[isEnabled() ? 0 : 1]);
+    painter.drawText(fLabelPos, fLabel);
+}
+
+bool PixmapDial::frameTick(qint64 time)
+{
+    // the first step of a fade is one frame long
+    const qint64 elapsed = (fHoverTime < 0) ? FrameScheduler::getInstance().getFramePeriod() : time - fHoverTime;
+    const float  steps   = float(elapsed) / 1000000000.0f / kHoverTime * float(HOVER_MAX - HOVER_MIN);
+
+    fHoverTime = time;
+
+    if (fHovered)
+        fHoverPosition = qMin(fHoverPosition + steps, float(HOVER_MAX));
     else
+        fHoverPosition = qMax(fHoverPosition - steps, float(HOVER_MIN));
+
+    const unsigned short step = (unsigned short)(fHoverPosition + 0.5f);
+
+    if (step != fHoverStep)
     {
-        QRectF target(0.0f, 0.0f, fSize, fSize);
-        painter.drawPixmap(target, fPixmap, target);
+        fHoverStep = step;
+        update();
     }
 
-    painter.restore();
+    return fHovered ? fHoverPosition < HOVER_MAX : fHoverPosition > HOVER_MIN;
 }
 
 void PixmapDial::resizeEvent(QResizeEvent* event)
@@ -18,10 +18,13 @@
 #ifndef __PIXMAPDIAL_HPP__
 #define __PIXMAPDIAL_HPP__
 
+#include "framescheduler.hpp"
+
 #include <QtGui/QPixmap>
 #include <QtWidgets/QDial>
 
-class PixmapDial : public QDial
+class PixmapDial : public QDial,
+                   public FrameScheduler::Client
 {
 public:
     enum CustomPaint {
@@ -33,6 +36,7 @@ public:
     };
 
     PixmapDial(QWidget* parent);
+    ~PixmapDial();
 
     int  getSize() const;
     void setCustomPaint(CustomPaint paint);
@@ -46,6 +50,13 @@ public:
 protected:
     void updateSizes();
 
+    // the dial at 'value' (0 to 1), from the process-wide frame cache
+    QPixmap getFrame(float value) const;
+    void renderLabel();
+    void startHoverAnimation();
+
+    bool frameTick(qint64 time);
+
     void enterEvent(QEvent* event);
     void leaveEvent(QEvent* event);
     void paintEvent(QPaintEvent* event);
@@ -60,6 +71,9 @@ private:
     static const unsigned short HOVER_MIN = 0;
     static const unsigned short HOVER_MAX = 9;
 
+    // positions cached per custom paint dial, plain ones have one per frame
+    static const int VALUE_STEPS = 256;
+
     // -------------------------------------
 
     QPixmap fPixmap;
@@ -70,6 +84,8 @@ private:
 
     bool fHovered;
     unsigned short fHoverStep;
+    float  fHoverPosition; // fractional step, moved by elapsed time
+    qint64 fHoverTime;     // of the last animation tick, -1 for none yet
 
     QString fLabel;
     QPointF fLabelPos;
@@ -80,6 +96,9 @@ private:
     QLinearGradient fLabelGradient;
     QRectF fLabelGradientRect;
 
+    // label and its background, drawn below the dial
+    QPixmap fLabelPixmap;
+
     QColor fColor1;
     QColor fColor2;
     QColor fColorT[2];
@@ -17,48 +17,50 @@
 
 #include "pixmapkeyboard.hpp"
 
-#include <QtCore/QTimer>
 #include <QtGui/QKeyEvent>
 #include <QtGui/QMouseEvent>
 #include <QtGui/QPainter>
 
-#ifndef Q_COMPILER_LAMBDA
-static std::map<int, QRectF> kMidiKey2RectMapHorizontal;
-#else
-static std::map<int, QRectF> kMidiKey2RectMapHorizontal = {
-    {0,  QRectF(0,   0, 18, 64)}, // C
-    {1,  QRectF(13,  0, 11, 42)}, // C#
-    {2,  QRectF(18,  0, 25, 64)}, // D
-    {3,  QRectF(37,  0, 11, 42)}, // D#
-    {4,  QRectF(42,  0, 18, 64)}, // E
-    {5,  QRectF(60,  0, 18, 64)}, // F
-    {6,  QRectF(73,  0, 11, 42)}, // F#
-    {7,  QRectF(78,  0, 25, 64)}, // G
-    {8,  QRectF(97,  0, 11, 42)}, // G#
-    {9,  QRectF(102, 0, 25, 64)}, // A
-    {10, QRectF(121, 0, 11, 42)}, // A#
-    {11, QRectF(126, 0, 18, 64)}  // B
+#include <cstring>
+#include <map>
+
+// key rectangles within one octave, indexed by note % 12
+static const QRectF kKeyRectsHorizontal[12] = {
+    QRectF(0,   0, 18, 64), // C
+    QRectF(13,  0, 11, 42), // C#
+    QRectF(18,  0, 25, 64), // D
+    QRectF(37,  0, 11, 42), // D#
+    QRectF(42,  0, 18, 64), // E
+    QRectF(60,  0, 18, 64), // F
+    QRectF(73,  0, 11, 42), // F#
+    QRectF(78,  0, 25, 64), // G
+    QRectF(97,  0, 11, 42), // G#
+    QRectF(102, 0, 25, 64), // A
+    QRectF(121, 0, 11, 42), // A#
+    QRectF(126, 0, 18, 64)  // B
 };
-#endif
 
-#ifndef Q_COMPILER_LAMBDA
-static std::map<int, QRectF> kMidiKey2RectMapVertical;
-#else
-static std::map<int, QRectF> kMidiKey2RectMapVertical = {
-    {11, QRectF(0,  0,  64, 18)}, // B
-    {10, QRectF(0, 14,  42,  7)}, // A#
-    {9,  QRectF(0, 18,  64, 24)}, // A
-    {8,  QRectF(0, 38,  42,  7)}, // G#
-    {7,  QRectF(0, 42,  64, 24)}, // G
-    {6,  QRectF(0, 62,  42,  7)}, // F#
-    {5,  QRectF(0, 66,  64, 18)}, // F
-    {4,  QRectF(0, 84,  64, 18)}, // E
-    {3,  QRectF(0, 98,  42,  7)}, // D#
-    {2,  QRectF(0, 102, 64, 24)}, // D
-    {1,  QRectF(0, 122, 42,  7)}, // C#
-    {0,  QRectF(0, 126, 64, 18)}  // C
+static const QRectF kKeyRectsVertical[12] = {
+    QRectF(0, 126, 64, 18), // C
+    QRectF(0, 122, 42,  7), // C#
+    QRectF(0, 102, 64, 24), // D
+    QRectF(0, 98,  42,  7), // D#
+    QRectF(0, 84,  64, 18), // E
+    QRectF(0, 66,  64, 18), // F
+    QRectF(0, 62,  42,  7), // F#
+    QRectF(0, 42,  64, 24), // G
+    QRectF(0, 38,  42,  7), // G#
+    QRectF(0, 18,  64, 24), // A
+    QRectF(0, 14,  42,  7), // A#
+    QRectF(0,  0,  64, 18)  // B
+};
+
+static const bool kBlackKeys[12] = {
+    false, true, false, true, false, false, true, false, true, false, true, false
 };
-#endif
+
+static const int kBlackNotes[5] = { 1, 3, 6, 8, 10 };
+static const int kWhiteNotes[7] = { 0, 2, 4, 5, 7, 9, 11 };
 
 #ifndef Q_COMPILER_LAMBDA
 static std::map<int, int> kMidiKeyboard2KeyMap;
@@ -93,43 +95,9 @@ static const std::map<int, int> kMidiKeyboard2KeyMap = {
 };
 #endif
 
-#ifndef Q_COMPILER_LAMBDA
-static QVector<int> kBlackNotes;
-#else
-static const QVector<int> kBlackNotes = {1, 3, 6, 8, 10};
-#endif
-
 #ifndef Q_COMPILER_LAMBDA
 static const struct PixmapKeyboardInit {
     PixmapKeyboardInit() {
-        // kMidiKey2RectMapHorizontal
-        kMidiKey2RectMapHorizontal[0]  = QRectF(0,   0, 18, 64); // C
-        kMidiKey2RectMapHorizontal[1]  = QRectF(13,  0, 11, 42); // C#
-        kMidiKey2RectMapHorizontal[2]  = QRectF(18,  0, 25, 64); // D
-        kMidiKey2RectMapHorizontal[3]  = QRectF(37,  0, 11, 42); // D#
-        kMidiKey2RectMapHorizontal[4]  = QRectF(42,  0, 18, 64); // E
-        kMidiKey2RectMapHorizontal[5]  = QRectF(60,  0, 18, 64); // F
-        kMidiKey2RectMapHorizontal[6]  = QRectF(73,  0, 11, 42); // F#
-        kMidiKey2RectMapHorizontal[7]  = QRectF(78,  0, 25, 64); // G
-        kMidiKey2RectMapHorizontal[8]  = QRectF(97,  0, 11, 42); // G#
-        kMidiKey2RectMapHorizontal[9]  = QRectF(102, 0, 25, 64); // A
-        kMidiKey2RectMapHorizontal[10] = QRectF(121, 0, 11, 42); // A#
-        kMidiKey2RectMapHorizontal[11] = QRectF(126, 0, 18, 64); // B
-
-        // kMidiKey2RectMapVertical
-        kMidiKey2RectMapVertical[11] = QRectF(0,  0,  64, 18); // B
-        kMidiKey2RectMapVertical[10] = QRectF(0, 14,  42,  7); // A#
-        kMidiKey2RectMapVertical[9]  = QRectF(0, 18,  64, 24); // A
-        kMidiKey2RectMapVertical[8]  = QRectF(0, 38,  42,  7); // G#
-        kMidiKey2RectMapVertical[7]  = QRectF(0, 42,  64, 24); // G
-        kMidiKey2RectMapVertical[6]  = QRectF(0, 62,  42,  7); // F#
-        kMidiKey2RectMapVertical[5]  = QRectF(0, 66,  64, 18); // F
-        kMidiKey2RectMapVertical[4]  = QRectF(0, 84,  64, 18); // E
-        kMidiKey2RectMapVertical[3]  = QRectF(0, 98,  42,  7); // D#
-        kMidiKey2RectMapVertical[2]  = QRectF(0, 102, 64, 24); // D
-        kMidiKey2RectMapVertical[1]  = QRectF(0, 122, 42,  7); // C#
-        kMidiKey2RectMapVertical[0]  = QRectF(0, 126, 64, 18); // C
-
         // kMidiKeyboard2KeyMap, 3th octave
         kMidiKeyboard2KeyMap[Qt::Key_Z] = 48;
         kMidiKeyboard2KeyMap[Qt::Key_S] = 49;
@@ -156,13 +124,6 @@ static const struct PixmapKeyboardInit {
         kMidiKeyboard2KeyMap[Qt::Key_Y] = 69;
         kMidiKeyboard2KeyMap[Qt::Key_7] = 70;
         kMidiKeyboard2KeyMap[Qt::Key_U] = 71;
-
-        // kBlackNotes
-        kBlackNotes << 1;
-        kBlackNotes << 3;
-        kBlackNotes << 6;
-        kBlackNotes << 8;
-        kBlackNotes << 10;
     }
 } _pixmapKeyboardInitInit;
 #endif
@@ -177,61 +138,111 @@ PixmapKeyboard::PixmapKeyboard(QWidget* parent)
       fLastMouseNote(-1),
       fWidth(0),
       fHeight(0),
-      fMidiMap(kMidiKey2RectMapHorizontal)
+      fUpdatePending(false),
+      fEnabledCount(0),
+      fKeyRects(kKeyRectsHorizontal)
 {
+    std::memset(fEnabledKeys, 0, sizeof(fEnabledKeys));
+    std::memset(fDirtyKeys,   0, sizeof(fDirtyKeys));
+    std::memset(fVelocities,  0, sizeof(fVelocities));
+    std::memset(fPressures,   0, sizeof(fPressures));
+
     setCursor(Qt::PointingHandCursor);
     setMode(HORIZONTAL);
 }
 
+PixmapKeyboard::~PixmapKeyboard()
+{
+    FrameScheduler::getInstance().unsubscribe(this);
+}
+
 void PixmapKeyboard::allNotesOff()
 {
-    fEnabledKeys.clear();
+    std::memset(fEnabledKeys, 0, sizeof(fEnabledKeys));
+    fEnabledCount = 0;
 
     emit notesOff();
     update();
 }
 
-void PixmapKeyboard::sendNoteOn(int note, bool sendSignal)
+void PixmapKeyboard::sendNoteOn(int note, bool sendSignal, int velocity)
 {
-    if (0 <= note && note <= 127 && ! fEnabledKeys.contains(note))
+    if (note < 0 || note > 127)
+        return;
+
+    if (velocity < 1)
+        velocity = 1;
+    else if (velocity > 127)
+        velocity = 127;
+
+    if (! fEnabledKeys[note])
     {
-        fEnabledKeys.append(note);
+        fEnabledKeys[note] = true;
+        fVelocities[note]  = velocity;
+        fPressures[note]   = 0;
+        ++fEnabledCount;
 
         if (sendSignal)
             emit noteOn(note);
 
-        update();
+        updateNote(note);
+    }
+    else if (fVelocities[note] != velocity)
+    {
+        // retriggered while held, only the shading changes
+        fVelocities[note] = velocity;
+        updateNote(note);
     }
 
-    if (fEnabledKeys.count() == 1)
+    if (fEnabledCount == 1)
         emit notesOn();
 }
 
 void PixmapKeyboard::sendNoteOff(int note, bool sendSignal)
 {
-    if (note >= 0 && note <= 127 && fEnabledKeys.contains(note))
+    if (note >= 0 && note <= 127 && fEnabledKeys[note])
     {
-        fEnabledKeys.removeOne(note);
+        fEnabledKeys[note] = false;
+        --fEnabledCount;
 
         if (sendSignal)
             emit noteOff(note);
 
-        update();
+        updateNote(note);
     }
 
-    if (fEnabledKeys.count() == 0)
+    if (fEnabledCount == 0)
         emit notesOff();
 }
 
+void PixmapKeyboard::setNotePressure(int note, int pressure)
+{
+    if (note < 0 || note > 127 || ! fEnabledKeys[note])
+        return;
+
+    if (pressure < 0)
+        pressure = 0;
+    else if (pressure > 127)
+        pressure = 127;
+
+    if (fPressures[note] == pressure)
+        return;
+
+    fPressures[note] = pressure;
+    updateNote(note);
+}
+
 void PixmapKeyboard::setMode(Orientation mode, Color color)
 {
     if (color == COLOR_CLASSIC)
     {
         fColorStr = "classic";
+        fPressureColor = QColor(60, 120, 220, 150);
     }
     else if (color == COLOR_ORANGE)
     {
         fColorStr = "orange";
+        fPressureColor = QColor(255, 100, 0, 150);
     }
     else
     {
@@ -241,7 +252,7 @@ void PixmapKeyboard::setMode(Orientation mode, Color color)
 
     if (mode == HORIZONTAL)
     {
-        fMidiMap = kMidiKey2RectMapHorizontal;
+        fKeyRects = kKeyRectsHorizontal;
         fPixmap.load(QString(":/bitmaps/kbd_h_%1.png").arg(fColorStr));
         fPixmapMode = HORIZONTAL;
         fWidth  = fPixmap.width();
@@ -249,7 +260,7 @@ void PixmapKeyboard::setMode(Orientation mode, Color color)
     }
     else if (mode == VERTICAL)
     {
-        fMidiMap = kMidiKey2RectMapVertical;
+        fKeyRects = kKeyRectsVertical;
         fPixmap.load(QString(":/bitmaps/kbd_v_%1.png").arg(fColorStr));
         fPixmapMode = VERTICAL;
         fWidth  = fPixmap.width() / 2;
@@ -261,6 +272,7 @@ void PixmapKeyboard::setMode(Orientation mode, Color color)
         return setMode(HORIZONTAL);
     }
 
+    updateHitTables();
     setOctaves(fOctaves);
 }
 
@@ -286,12 +298,13 @@ void PixmapKeyboard::setOctaves(int octaves)
         setMaximumSize(fWidth, fHeight * fOctaves);
     }
 
+    fIdlePixmap = QPixmap();
     update();
 }
 
 void PixmapKeyboard::handleMousePos(const QPoint& pos)
 {
-    int note, octave;
+    int note, octave, along;
     QPointF keyPos;
 
     if (fPixmapMode == HORIZONTAL)
@@ -300,45 +313,34 @@ void PixmapKeyboard::handleMousePos(const QPoint& pos)
             return;
         int posX = pos.x() - 1;
         octave = posX / fWidth;
-        keyPos = QPointF(posX % fWidth, pos.y());
+        along  = posX % fWidth;
+        keyPos = QPointF(along, pos.y());
     }
     else if (fPixmapMode == VERTICAL)
     {
         if (pos.y() < 0 or pos.y() > fOctaves * 144)
             return;
         int posY = pos.y() - 1;
-        octave = fOctaves - posY / fHeight;
-        keyPos = QPointF(pos.x(), posY % fHeight);
+        octave = fOctaves - posY / fHeight - 1;
+        along  = posY % fHeight;
+        keyPos = QPointF(pos.x(), along);
     }
     else
         return;
 
-    if (fMidiMap[1].contains(keyPos))      // C#
-        note = 1;
-    else if (fMidiMap[3].contains(keyPos)) // D#
-        note = 3;
-    else if (fMidiMap[6].contains(keyPos)) // F#
-        note = 6;
-    else if (fMidiMap[8].contains(keyPos)) // G#
-        note = 8;
-    else if (fMidiMap[10].contains(keyPos))// A#
-        note = 10;
-    else if (fMidiMap[0].contains(keyPos)) // C
-        note = 0;
-    else if (fMidiMap[2].contains(keyPos)) // D
-        note = 2;
-    else if (fMidiMap[4].contains(keyPos)) // E
-        note = 4;
-    else if (fMidiMap[5].contains(keyPos)) // F
-        note = 5;
-    else if (fMidiMap[7].contains(keyPos)) // G
-        note = 7;
-    else if (fMidiMap[9].contains(keyPos)) // A
-        note = 9;
-    else if (fMidiMap[11].contains(keyPos))// B
-        note = 11;
-    else
-        note = -1;
+    note = -1;
+
+    if (along >= 0 && along < kOctaveLength)
+    {
+        // black keys are on top, only fall back to white if missed
+        const int black = fBlackHits[along];
+        const int white = fWhiteHits[along];
+
+        if (black != -1 && fKeyRects[black].contains(keyPos))
+            note = black;
+        else if (white != -1 && fKeyRects[white].contains(keyPos))
+            note = white;
+    }
 
     if (note != -1)
     {
@@ -409,83 +411,32 @@ void PixmapKeyboard::paintEvent(QPaintEvent* event)
     QPainter painter(this);
     event->accept();
 
-    // -------------------------------------------------------------
-    // Paint clean keys (as background)
-
-    for (int octave=0; octave < fOctaves; ++octave)
-    {
-        QRectF target;
+    if (fIdlePixmap.isNull())
+        renderIdlePixmap();
 
-        if (fPixmapMode == HORIZONTAL)
-            target = QRectF(fWidth * octave, 0, fWidth, fHeight);
-        else if (fPixmapMode == VERTICAL)
-            target = QRectF(0, fHeight * octave, fWidth, fHeight);
-        else
-            return;
+    // -------------------------------------------------------------
+    // Paint clean keys and labels (as background), only what changed
 
-        QRectF source = QRectF(0, 0, fWidth, fHeight);
-        painter.drawPixmap(target, fPixmap, source);
-    }
+    const QRect dirty(event->rect());
+    painter.drawPixmap(dirty, fIdlePixmap, dirty);
 
     // -------------------------------------------------------------
     // Paint (white) pressed keys
 
+    const int noteCount = qMin(fOctaves * 12, 128);
     bool paintedWhite = false;
 
-    for (int i=0, count=fEnabledKeys.count(); i < count; ++i)
+    for (int note=0; note < noteCount; ++note)
     {
-        int octave, note = fEnabledKeys[i];
-        const QRectF& pos(_getRectFromMidiNote(note));
-
-        if (_isNoteBlack(note))
+        if (! fEnabledKeys[note] || _isNoteBlack(note) || ! getNoteTarget(note).intersects(dirty))
             continue;
 
-        if (note < 12)
-            octave = 0;
-        else if (note < 24)
-            octave = 1;
-        else if (note < 36)
-            octave = 2;
-        else if (note < 48)
-            octave = 3;
-        else if (note < 60)
-            octave = 4;
-        else if (note < 72)
-            octave = 5;
-        else if (note < 84)
-            octave = 6;
-        else if (note < 96)
-            octave = 7;
-        else if (note < 108)
-            octave = 8;
-        else if (note < 120)
-            octave = 9;
-        else if (note < 132)
-            octave = 10;
-        else
-            // cannot paint this note
-            continue;
-
-        if (fPixmapMode == VERTICAL)
-            octave = fOctaves - octave - 1;
-
-        QRectF target, source;
-
-        if (fPixmapMode == HORIZONTAL)
-        {
-            target = QRectF(pos.x() + (fWidth * octave), 0, pos.width(), pos.height());
-            source = QRectF(pos.x(), fHeight, pos.width(), pos.height());
-        }
-        else if (fPixmapMode == VERTICAL)
-        {
-            target = QRectF(pos.x(), pos.y() + (fHeight * octave), pos.width(), pos.height());
-            source = QRectF(fWidth, pos.y(), pos.width(), pos.height());
-        }
-        else
-            return;
-
         paintedWhite = true;
-        painter.drawPixmap(target, fPixmap, source);
+        paintNote(painter, note);
+
+        // pressed C keys cover their label
+        if (note % 12 == 0)
+            paintLabel(painter, note / 12);
     }
 
     // -------------------------------------------------------------
@@ -495,25 +446,12 @@ void PixmapKeyboard::paintEvent(QPaintEvent* event)
     {
         for (int octave=0; octave < fOctaves; ++octave)
         {
-            foreach (int note, kBlackNotes)
+            for (int i=0; i < 5; ++i)
             {
-                QRectF target, source;
-                const QRectF& pos(_getRectFromMidiNote(note));
-
-                if (fPixmapMode == HORIZONTAL)
-                {
-                    target = QRectF(pos.x() + (fWidth * octave), 0, pos.width(), pos.height());
-                    source = QRectF(pos.x(), 0, pos.width(), pos.height());
-                }
-                else if (fPixmapMode == VERTICAL)
-                {
-                    target = QRectF(pos.x(), pos.y() + (fHeight * octave), pos.width(), pos.height());
-                    source = QRectF(0, pos.y(), pos.width(), pos.height());
-                }
-                else
-                    return;
-
-                painter.drawPixmap(target, fPixmap, source);
+                const QRectF target(getNoteTarget(octave*12 + kBlackNotes[i]));
+
+                if (target.intersects(dirty))
+                    painter.drawPixmap(target, fIdlePixmap, target);
             }
         }
     }
@@ -521,82 +459,168 @@ void PixmapKeyboard::paintEvent(QPaintEvent* event)
     // -------------------------------------------------------------
     // Paint (black) pressed keys
 
-    for (int i=0, count=fEnabledKeys.count(); i < count; ++i)
+    for (int note=0; note < noteCount; ++note)
     {
-        int octave, note = fEnabledKeys[i];
-        const QRectF& pos(_getRectFromMidiNote(note));
-
-        if (! _isNoteBlack(note))
+        if (! fEnabledKeys[note] || ! _isNoteBlack(note) || ! getNoteTarget(note).intersects(dirty))
             continue;
 
-        if (note < 12)
-            octave = 0;
-        else if (note < 24)
-            octave = 1;
-        else if (note < 36)
-            octave = 2;
-        else if (note < 48)
-            octave = 3;
-        else if (note < 60)
-            octave = 4;
-        else if (note < 72)
-            octave = 5;
-        else if (note < 84)
-            octave = 6;
-        else if (note < 96)
-            octave = 7;
-        else if (note < 108)
-            octave = 8;
-        else if (note < 120)
-            octave = 9;
-        else if (note < 132)
-            octave = 10;
-        else
-            // cannot paint this note
-            continue;
+        paintNote(painter, note);
+    }
+}
 
-        if (fPixmapMode == VERTICAL)
-            octave = fOctaves - octave - 1;
+void PixmapKeyboard::paintNote(QPainter& painter, int note)
+{
+    const QRectF target(getNoteTarget(note));
 
-        QRectF target, source;
+    // soft notes are only partially pressed
+    painter.setOpacity(0.35 + 0.65 * fVelocities[note] / 127.0);
+    painter.drawPixmap(target, fPixmap, getNoteSource(note));
+    painter.setOpacity(1.0);
 
-        if (fPixmapMode == HORIZONTAL)
-        {
-            target = QRectF(pos.x() + (fWidth * octave), 0, pos.width(), pos.height());
-            source = QRectF(pos.x(), fHeight, pos.width(), pos.height());
-        }
-        else if (fPixmapMode == VERTICAL)
-        {
-            target = QRectF(pos.x(), pos.y() + (fHeight * octave), pos.width(), pos.height());
-            source = QRectF(fWidth, pos.y(), pos.width(), pos.height());
-        }
-        else
-            return;
+    if (fPressures[note] == 0)
+        return;
 
-        painter.drawPixmap(target, fPixmap, source);
+    // pressure fills the key from its front edge
+    const qreal pressure = fPressures[note] / 127.0;
+
+    if (fPixmapMode == HORIZONTAL)
+    {
+        const qreal height = target.height() * pressure;
+        painter.fillRect(QRectF(target.x(), target.bottom() - height, target.width(), height), fPressureColor);
     }
+    else
+    {
+        const qreal width = target.width() * pressure;
+        painter.fillRect(QRectF(target.right() - width, target.y(), width, target.height()), fPressureColor);
+    }
+}
 
-    // Paint C-number note info
+void PixmapKeyboard::paintLabel(QPainter& painter, int octave)
+{
+    // C-number note info
     painter.setFont(fFont);
     painter.setPen(Qt::black);
 
-    for (int i=0; i < fOctaves; ++i)
+    if (fPixmapMode == HORIZONTAL)
+        painter.drawText(octave * 144, 48, 18, 18, Qt::AlignCenter, QString("C%1").arg(octave-1));
+    else if (fPixmapMode == VERTICAL)
+        painter.drawText(45, (fOctaves * 144) - (octave * 144) - 16, 18, 18, Qt::AlignCenter, QString("C%1").arg(octave-1));
+}
+
+void PixmapKeyboard::renderIdlePixmap()
+{
+    if (fPixmapMode == HORIZONTAL)
+        fIdlePixmap = QPixmap(fWidth * fOctaves, fHeight);
+    else
+        fIdlePixmap = QPixmap(fWidth, fHeight * fOctaves);
+
+    fIdlePixmap.fill(Qt::transparent);
+
+    QPainter painter(&fIdlePixmap);
+
+    for (int octave=0; octave < fOctaves; ++octave)
     {
+        QRectF target;
+
         if (fPixmapMode == HORIZONTAL)
-            painter.drawText(i * 144, 48, 18, 18, Qt::AlignCenter, QString("C%1").arg(i-1));
-        else if (fPixmapMode == VERTICAL)
-            painter.drawText(45, (fOctaves * 144) - (i * 144) - 16, 18, 18, Qt::AlignCenter, QString("C%1").arg(i-1));
+            target = QRectF(fWidth * octave, 0, fWidth, fHeight);
+        else
+            target = QRectF(0, fHeight * octave, fWidth, fHeight);
+
+        QRectF source = QRectF(0, 0, fWidth, fHeight);
+        painter.drawPixmap(target, fPixmap, source);
+    }
+
+    for (int octave=0; octave < fOctaves; ++octave)
+        paintLabel(painter, octave);
+}
+
+void PixmapKeyboard::updateNote(int note)
+{
+    fDirtyKeys[note] = true;
+
+    // notes that change in the same frame share one update,
+    // no matter how many messages they got in between
+    if (! fUpdatePending)
+    {
+        fUpdatePending = true;
+        FrameScheduler::getInstance().subscribe(this);
+    }
+}
+
+bool PixmapKeyboard::frameTick(qint64)
+{
+    QRegion region;
+
+    for (int note=0; note < 128; ++note)
+    {
+        if (! fDirtyKeys[note])
+            continue;
+
+        fDirtyKeys[note] = false;
+        region += getNoteTarget(note).toAlignedRect();
+    }
+
+    update(region);
+
+    fUpdatePending = false;
+    return false;
+}
+
+QRectF PixmapKeyboard::getNoteTarget(int note) const
+{
+    const QRectF& pos(_getRectFromMidiNote(note));
+    int octave = note / 12;
+
+    if (fPixmapMode == VERTICAL)
+    {
+        octave = fOctaves - octave - 1;
+        return QRectF(pos.x(), pos.y() + (fHeight * octave), pos.width(), pos.height());
+    }
+
+    return QRectF(pos.x() + (fWidth * octave), 0, pos.width(), pos.height());
+}
+
+QRectF PixmapKeyboard::getNoteSource(int note) const
+{
+    const QRectF& pos(_getRectFromMidiNote(note));
+
+    // pressed keys are the second half of the pixmap
+    if (fPixmapMode == VERTICAL)
+        return QRectF(fWidth, pos.y(), pos.width(), pos.height());
+
+    return QRectF(pos.x(), fHeight, pos.width(), pos.height());
+}
+
+void PixmapKeyboard::updateHitTables()
+{
+    for (int i=0; i < kOctaveLength; ++i)
+    {
+        const QPointF point(fPixmapMode == HORIZONTAL ? QPointF(i, 0) : QPointF(0, i));
+
+        fBlackHits[i] = -1;
+        fWhiteHits[i] = -1;
+
+        for (int j=0; j < 5 && fBlackHits[i] == -1; ++j)
+        {
+            if (fKeyRects[kBlackNotes[j]].contains(point))
+                fBlackHits[i] = kBlackNotes[j];
+        }
+
+        for (int j=0; j < 7 && fWhiteHits[i] == -1; ++j)
+        {
+            if (fKeyRects[kWhiteNotes[j]].contains(point))
+                fWhiteHits[i] = kWhiteNotes[j];
+        }
     }
 }
 
 bool PixmapKeyboard::_isNoteBlack(int note) const
 {
-    const int baseNote = note % 12;
-    return kBlackNotes.contains(baseNote);
+    return kBlackKeys[note % 12];
 }
 
 const QRectF& PixmapKeyboard::_getRectFromMidiNote(int note) const
 {
-    const int baseNote = note % 12;
-    return fMidiMap[baseNote];
+    return fKeyRects[note % 12];
 }
@@ -18,11 +18,13 @@
 #ifndef __PIXMAPKEYBOARD_HPP__
 #define __PIXMAPKEYBOARD_HPP__
 
-#include <map>
+#include "framescheduler.hpp"
+
 #include <QtGui/QPixmap>
 #include <QtWidgets/QWidget>
 
-class PixmapKeyboard : public QWidget
+class PixmapKeyboard : public QWidget,
+                       public FrameScheduler::Client
 {
     Q_OBJECT
 
@@ -38,10 +40,12 @@ public:
     };
 
     PixmapKeyboard(QWidget* parent);
+    ~PixmapKeyboard();
 
     void allNotesOff();
-    void sendNoteOn(int note, bool sendSignal=true);
+    void sendNoteOn(int note, bool sendSignal=true, int velocity=100);
     void sendNoteOff(int note, bool sendSignal=true);
+    void setNotePressure(int note, int pressure); // held notes only
 
     void setMode(Orientation mode, Color color=COLOR_ORANGE);
     void setOctaves(int octaves);
@@ -55,6 +59,22 @@ signals:
 protected:
     void handleMousePos(const QPoint&);
 
+    // idle keyboard with labels, rebuilt on mode or octave changes
+    void renderIdlePixmap();
+    void paintLabel(QPainter& painter, int octave);
+    void paintNote(QPainter& painter, int note);
+
+    // marks a note's key dirty, repainted on the next frame
+    void updateNote(int note);
+    bool frameTick(qint64 time);
+
+    // where a note goes on the widget, and its pressed image in the pixmap
+    QRectF getNoteTarget(int note) const;
+    QRectF getNoteSource(int note) const;
+
+    // key under each pixel along one octave, for both key rows
+    void updateHitTables();
+
     void keyPressEvent(QKeyEvent*);
     void keyReleaseEvent(QKeyEvent*);
     void mousePressEvent(QMouseEvent*);
@@ -64,9 +84,11 @@ protected:
 
 private:
     QPixmap     fPixmap;
+    QPixmap     fIdlePixmap;
     Orientation fPixmapMode;
 
     QString fColorStr;
+    QColor  fPressureColor;
     QFont   fFont;
 
     int fOctaves;
@@ -74,8 +96,20 @@ private:
     int fWidth;
     int fHeight;
 
-    QList<int> fEnabledKeys;
-    std::map<int, QRectF>& fMidiMap;
+    bool fDirtyKeys[128];
+    bool fUpdatePending;
+
+    bool  fEnabledKeys[128];
+    int   fEnabledCount;
+    uchar fVelocities[128];
+    uchar fPressures[128];
+
+    // pixels of one octave along the keyboard
+    static const int kOctaveLength = 144;
+
+    const QRectF* fKeyRects; // indexed by note % 12
+    qint8 fBlackHits[kOctaveLength];
+    qint8 fWhiteHits[kOctaveLength];
 
     bool _isNoteBlack(int note) const;
     const QRectF& _getRectFromMidiNote(int note) const;
@@ -0,0 +1,141 @@
+/*
+ * Spectrum View, a custom Qt4 widget
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "spectrumview.hpp"
+
+#include <cmath>
+
+#include <QtGui/QContextMenuEvent>
+#include <QtGui/QPainter>
+#include <QtGui/QPaintEvent>
+#include <QtGui/QPolygonF>
+#include <QtWidgets/QMenu>
+
+static const float kLowestFreq = 20.0f;
+static const float kRangeDB    = 90.0f;
+
+SpectrumView::SpectrumView(QWidget* parent)
+    : QWidget(parent),
+      fSampleRate(48000.0),
+      fColorBackground("#111111"),
+      fColorBase(93, 231, 61),
+      fColorBaseAlt(15, 110, 15, 100),
+      fColorGrid(60, 60, 60)
+{
+}
+
+bool SpectrumView::setFftSize(double sampleRate, uint32_t fftSize)
+{
+    if (! fAnalyzer.init(sampleRate, fftSize))
+        return false;
+
+    fSampleRate = sampleRate;
+    update();
+    return true;
+}
+
+void SpectrumView::addSamples(const float* samples, uint32_t count)
+{
+    if (fAnalyzer.addSamples(samples, count))
+        update();
+}
+
+QSize SpectrumView::minimumSizeHint() const
+{
+    return QSize(60, 40);
+}
+
+QSize SpectrumView::sizeHint() const
+{
+    return QSize(300, 150);
+}
+
+void SpectrumView::contextMenuEvent(QContextMenuEvent* event)
+{
+    QMenu menu(this);
+
+    for (uint32_t size = SpectrumAnalyzer::kMinSize; size <= SpectrumAnalyzer::kMaxSize; size *= 2)
+    {
+        QAction* const action = menu.addAction(tr("%1-point FFT").arg(size));
+        action->setData(size);
+        action->setCheckable(true);
+        action->setChecked(size == fAnalyzer.getSize());
+    }
+
+    if (QAction* const action = menu.exec(event->globalPos()))
+        setFftSize(fSampleRate, action->data().toUInt());
+
+    event->accept();
+}
+
+void SpectrumView::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+    event->accept();
+
+    const int w = width();
+    const int h = height();
+
+    painter.fillRect(0, 0, w, h, fColorBackground);
+
+    const uint32_t bands = fAnalyzer.getBands();
+
+    if (bands == 0 || w <= 0)
+        return;
+
+    const float logLow   = std::log10(kLowestFreq);
+    const float logRange = std::log10(fAnalyzer.getBandFrequency(bands-1)) - logLow;
+
+    // grid, every decade and every 20 dB
+    painter.setPen(fColorGrid);
+
+    for (float freq = 100.0f; freq < 20000.0f; freq *= 10.0f)
+    {
+        const int x = int((std::log10(freq) - logLow) / logRange * float(w));
+        painter.drawLine(x, 0, x, h);
+    }
+
+    for (int db = 20; db < int(kRangeDB); db += 20)
+    {
+        const int y = int(float(db) / kRangeDB * float(h));
+        painter.drawLine(0, y, w, y);
+    }
+
+    // spectrum, closed along the bottom so it can be filled
+    QPolygonF polygon;
+    polygon.reserve(int(bands) + 2);
+    polygon << QPointF(0.0, h);
+
+    for (uint32_t i=0; i < bands; ++i)
+    {
+        const float x = (std::log10(fAnalyzer.getBandFrequency(i)) - logLow) / logRange * float(w);
+        const float y = qBound(0.0f, -fAnalyzer.getBandLevel(i) / kRangeDB, 1.0f) * float(h);
+        polygon << QPointF(x, y);
+    }
+
+    polygon << QPointF(w, h);
+
+    painter.setPen(fColorBase);
+    painter.setBrush(fColorBaseAlt);
+    painter.drawPolygon(polygon);
+
+    QFont font(painter.font());
+    font.setPixelSize(9);
+    painter.setFont(font);
+    painter.setPen(Qt::white);
+    painter.drawText(QRect(2, 2, w - 4, 12), Qt::AlignRight | Qt::AlignTop, tr("%1 pt").arg(fAnalyzer.getSize()));
+}
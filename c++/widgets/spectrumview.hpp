@@ -0,0 +1,56 @@
+/*
+ * Spectrum View, a custom Qt4 widget
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __SPECTRUMVIEW_HPP__
+#define __SPECTRUMVIEW_HPP__
+
+#include "../dsp/spectrum.hpp"
+
+#include <QtWidgets/QWidget>
+
+// Spectrum on a logarithmic frequency axis, from -90 to 0 dB.
+// All analysis runs in the thread calling addSamples() (the GUI).
+// The FFT size can be changed from the context menu.
+
+class SpectrumView : public QWidget
+{
+public:
+    SpectrumView(QWidget* parent);
+
+    // not realtime safe
+    bool setFftSize(double sampleRate, uint32_t fftSize);
+
+    void addSamples(const float* samples, uint32_t count);
+
+    QSize minimumSizeHint() const;
+    QSize sizeHint() const;
+
+protected:
+    void contextMenuEvent(QContextMenuEvent* event);
+    void paintEvent(QPaintEvent* event);
+
+private:
+    SpectrumAnalyzer fAnalyzer;
+    double fSampleRate;
+
+    QColor fColorBackground;
+    QColor fColorBase;
+    QColor fColorBaseAlt;
+    QColor fColorGrid;
+};
+
+#endif // __SPECTRUMVIEW_HPP__
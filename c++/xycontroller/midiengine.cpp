@@ -0,0 +1,85 @@
+/*
+ * XY Controller for JACK, realtime engine
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#include "midiengine.hpp"
+
+MidiEngine::MidiEngine()
+    : fMidiIn(nullptr),
+      fMidiOut(nullptr)
+{
+    fInput.setSize(kQueueSize);
+    fOutput.setSize(kQueueSize);
+}
+
+bool MidiEngine::registerPorts(jack_client_t* const client)
+{
+    fMidiIn  = jackbridge_port_register(client, "midi_in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+    fMidiOut = jackbridge_port_register(client, "midi_out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+
+    return (fMidiIn != nullptr && fMidiOut != nullptr);
+}
+
+RingBuffer<MidiMessage>& MidiEngine::getInput()
+{
+    return fInput;
+}
+
+RingBuffer<MidiMessage>& MidiEngine::getOutput()
+{
+    return fOutput;
+}
+
+bool MidiEngine::process(const jack_nframes_t nframes)
+{
+    void* const midiInBuffer  = jackbridge_port_get_buffer(fMidiIn, nframes);
+    void* const midiOutBuffer = jackbridge_port_get_buffer(fMidiOut, nframes);
+
+    if (! (midiInBuffer && midiOutBuffer))
+        return false;
+
+    // MIDI In
+    const uint32_t midiEventCount = jackbridge_midi_get_event_count(midiInBuffer);
+    jack_midi_event_t midiEvent;
+
+    for (uint32_t i=0; i < midiEventCount; ++i)
+    {
+        if (! jackbridge_midi_event_get(&midiEvent, midiInBuffer, i))
+            break;
+        if (midiEvent.size == 0 || midiEvent.buffer[0] == 0)
+            continue;
+
+        MidiMessage message;
+        message.size    = (midiEvent.size < 3) ? uint8_t(midiEvent.size) : 3;
+        message.data[0] = midiEvent.buffer[0];
+        message.data[1] = (midiEvent.size >= 2) ? midiEvent.buffer[1] : 0;
+        message.data[2] = (midiEvent.size >= 3) ? midiEvent.buffer[2] : 0;
+
+        // the GUI is not keeping up, drop the rest of this cycle
+        if (! fInput.put(message))
+            break;
+    }
+
+    // MIDI Out
+    jackbridge_midi_clear_buffer(midiOutBuffer);
+
+    MidiMessage message;
+
+    while (fOutput.get(message))
+        jackbridge_midi_event_write(midiOutBuffer, 0, message.data, message.size);
+
+    return true;
+}
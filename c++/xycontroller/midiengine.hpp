@@ -0,0 +1,64 @@
+/*
+ * XY Controller for JACK, realtime engine
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the COPYING file
+ */
+
+#ifndef __MIDIENGINE_HPP__
+#define __MIDIENGINE_HPP__
+
+#include "../jackbridge/JackBridge.hpp"
+#include "../ring_buffer.hpp"
+
+// -------------------------------
+// Everything that runs inside the JACK process callback.
+// Incoming events go to the GUI and outgoing ones come from it through
+// lock-free ring buffers, so the JACK thread never waits on the GUI.
+// Messages longer than 3 bytes (sysex) are cut, the GUI has no use for them.
+// The limits are those of the old mutex Queue: 512 messages each way, and
+// new ones are dropped while a direction is full.
+
+struct MidiMessage {
+    uint8_t size;
+    uint8_t data[3];
+};
+
+class MidiEngine
+{
+public:
+    static const uint32_t kQueueSize = 512;
+
+    MidiEngine();
+
+    // not realtime safe, call before activating the client
+    bool registerPorts(jack_client_t* client);
+
+    // JACK thread, returns false if the port buffers are not available
+    bool process(jack_nframes_t nframes);
+
+    // JACK thread -> GUI
+    RingBuffer<MidiMessage>& getInput();
+
+    // GUI -> JACK thread, all sent at the start of the next cycle
+    RingBuffer<MidiMessage>& getOutput();
+
+private:
+    jack_port_t* fMidiIn;
+    jack_port_t* fMidiOut;
+
+    RingBuffer<MidiMessage> fInput;
+    RingBuffer<MidiMessage> fOutput;
+};
+
+#endif // __MIDIENGINE_HPP__
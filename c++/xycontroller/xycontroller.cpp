@@ -24,7 +24,9 @@
 #define VERSION "0.8.1"
 
 #include "../jack_utils.hpp"
-#include "../midi_queue.hpp"
+#include "../jack_profiler.hpp"
+#include "../widgets/framescheduler.hpp"
+#include "midiengine.hpp"
 #include "ui_xycontroller.h"
 
 #include <QtCore/QSettings>
@@ -45,11 +47,16 @@ float abs_f(const float value)
 }
 
 jack_client_t* jClient = nullptr;
-jack_port_t* jMidiInPort  = nullptr;
-jack_port_t* jMidiOutPort = nullptr;
 
-static Queue qMidiInData;
-static Queue qMidiOutData;
+MidiEngine   gEngine;
+JackProfiler gProfiler;
+
+// GUI thread only, dropped if the JACK thread is not keeping up
+static void send_midi(const uint8_t d1, const uint8_t d2, const uint8_t d3)
+{
+    const MidiMessage message = { 3, { d1, d2, d3 } };
+    gEngine.getOutput().put(message);
+}
 
 QVector<QString> MIDI_CC_LIST;
 void MIDI_CC_LIST__init()
@@ -356,14 +363,14 @@ protected:
         {
             int value = *xp * rate + rate;
             foreach (const int& channel, m_channels)
-                qMidiOutData.put(0xB0 + channel - 1, cc_x, value);
+                send_midi(0xB0 + channel - 1, cc_x, value);
         }
 
         if (yp != nullptr)
         {
             int value = *yp * rate + rate;
             foreach (const int& channel, m_channels)
-                qMidiOutData.put(0xB0 + channel - 1, cc_y, value);
+                send_midi(0xB0 + channel - 1, cc_y, value);
         }
     }
 
@@ -432,7 +439,8 @@ namespace Ui {
 class XYControllerW;
 }
 
-class XYControllerW : public QMainWindow
+class XYControllerW : public QMainWindow,
+                      public FrameScheduler::Client
 {
     Q_OBJECT
 
@@ -451,6 +459,9 @@ public:
         cc_x = 1;
         cc_y = 2;
 
+        for (int i=0; i < 128; ++i)
+            m_noteChannels[i] = 0;
+
         // -------------------------------------------------------------
         // Set-up GUI stuff
 
@@ -515,10 +526,16 @@ public:
         // -------------------------------------------------------------
         // Final stuff
 
-        m_midiInTimerId = startTimer(30);
+        FrameScheduler::getInstance().subscribe(this, 30);
+        m_profileTimerId = gProfiler.isEnabled() ? startTimer(5000) : 0;
         QTimer::singleShot(0, this, SLOT(slot_updateScreen()));
     }
 
+    ~XYControllerW()
+    {
+        FrameScheduler::getInstance().unsubscribe(this);
+    }
+
     void updateScreen()
     {
         scene.updateSize(ui->graphicsView->size());
@@ -535,13 +552,13 @@ protected slots:
     void slot_noteOn(int note)
     {
         foreach (const int& channel, m_channels)
-            qMidiOutData.put(0x90 + channel - 1, note, 100);
+            send_midi(0x90 + channel - 1, note, 100);
     }
 
     void slot_noteOff(int note)
     {
         foreach (const int& channel, m_channels)
-            qMidiOutData.put(0x80 + channel - 1, note, 0);
+            send_midi(0x80 + channel - 1, note, 0);
     }
 
     void slot_updateSceneX(int x)
@@ -804,35 +821,60 @@ protected:
             ui->act_ch_16->setChecked(true);
     }
 
-    void timerEvent(QTimerEvent* event)
+    bool frameTick(qint64)
     {
-        if (event->timerId() == m_midiInTimerId)
+        RingBuffer<MidiMessage>& input(gEngine.getInput());
+        MidiMessage message;
+
+        while (input.get(message))
         {
-            if (! qMidiInData.isEmpty())
-            {
-                unsigned char d1, d2, d3;
-                qMidiInInternal.copyDataFrom(&qMidiInData);
+            const uint8_t d1 = message.data[0];
+            const uint8_t d2 = message.data[1];
+            const uint8_t d3 = message.data[2];
 
-                while (qMidiInInternal.get(&d1, &d2, &d3, false))
-                {
-                    int channel = (d1 & 0x0F) + 1;
-                    int mode    = d1 & 0xF0;
+            int channel = (d1 & 0x0F) + 1;
+            int mode    = d1 & 0xF0;
 
-                    if (m_channels.contains(channel))
+            if (m_channels.contains(channel))
+            {
+                if (mode == 0x80 || (mode == 0x90 && d3 == 0))
+                {
+                    ui->keyboard->sendNoteOff(d2, false);
+                }
+                else if (mode == 0x90)
+                {
+                    m_noteChannels[d2 & 0x7F] = channel;
+                    ui->keyboard->sendNoteOn(d2, false, d3);
+                }
+                else if (mode == 0xA0)
+                {
+                    ui->keyboard->setNotePressure(d2, d3);
+                }
+                else if (mode == 0xB0)
+                {
+                    scene.handleCC(d2, d3);
+                }
+                else if (mode == 0xD0)
+                {
+                    // MPE controllers give each note its own channel
+                    for (int note=0; note < 128; ++note)
                     {
-                        if (mode == 0x80)
-                            ui->keyboard->sendNoteOff(d2, false);
-                        else if (mode == 0x90)
-                            ui->keyboard->sendNoteOn(d2, false);
-                        else if (mode == 0xB0)
-                            scene.handleCC(d2, d3);
+                        if (m_noteChannels[note] == channel)
+                            ui->keyboard->setNotePressure(note, d2);
                     }
                 }
             }
-
-            scene.updateSmooth();
         }
 
+        scene.updateSmooth();
+        return true;
+    }
+
+    void timerEvent(QTimerEvent* event)
+    {
+        if (event->timerId() == m_profileTimerId)
+            gProfiler.dump("process");
+
         QMainWindow::timerEvent(event);
     }
 
@@ -852,70 +894,25 @@ private:
     int cc_x;
     int cc_y;
     QList<int> m_channels;
+    int m_noteChannels[128]; // last channel each note was played on
 
-    int m_midiInTimerId;
+    int m_profileTimerId;
 
     QSettings settings;
     XYGraphicsScene scene;
     Ui::XYControllerW* const ui;
-
-    Queue qMidiInInternal;
 };
 
 #include "xycontroller.moc"
 
 // -------------------------------
 
-int process_callback(const jack_nframes_t nframes, void*)
+int process_callback(const jack_nframes_t nframes, void* const arg)
 {
-    void* const midiInBuffer  = jackbridge_port_get_buffer(jMidiInPort, nframes);
-    void* const midiOutBuffer = jackbridge_port_get_buffer(jMidiOutPort, nframes);
-
-    if (! (midiInBuffer && midiOutBuffer))
-        return 1;
-
-    // MIDI In
-    jack_midi_event_t midiEvent;
-    uint32_t midiEventCount = jackbridge_midi_get_event_count(midiInBuffer);
-
-    qMidiInData.lock();
-
-    for (uint32_t i=0; i < midiEventCount; i++)
-    {
-        if (! jackbridge_midi_event_get(&midiEvent, midiInBuffer, i))
-            break;
-
-        if (midiEvent.size == 1)
-            qMidiInData.put(midiEvent.buffer[0], 0, 0, false);
-        else if (midiEvent.size == 2)
-            qMidiInData.put(midiEvent.buffer[0], midiEvent.buffer[1], 0, false);
-        else if (midiEvent.size >= 3)
-            qMidiInData.put(midiEvent.buffer[0], midiEvent.buffer[1], midiEvent.buffer[2], false);
-
-        if (qMidiInData.isFull())
-            break;
-    }
-    qMidiInData.unlock();
-
-    // MIDI Out
-    jackbridge_midi_clear_buffer(midiOutBuffer);
-    qMidiOutData.lock();
-
-    if (! qMidiOutData.isEmpty())
-    {
-        unsigned char d1, d2, d3, data[3];
-
-        while (qMidiOutData.get(&d1, &d2, &d3, false))
-        {
-            data[0] = d1;
-            data[1] = d2;
-            data[2] = d3;
-            jackbridge_midi_event_write(midiOutBuffer, 0, data, 3);
-        }
-    }
-    qMidiOutData.unlock();
-
-    return 0;
+    gProfiler.begin();
+    const bool ok = ((MidiEngine*)arg)->process(nframes);
+    gProfiler.end();
+    return ok ? 0 : 1;
 }
 
 #ifdef HAVE_JACKSESSION
@@ -973,10 +970,13 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    jMidiInPort  = jackbridge_port_register(jClient, "midi_in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
-    jMidiOutPort = jackbridge_port_register(jClient, "midi_out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+    gEngine.registerPorts(jClient);
 
-    jackbridge_set_process_callback(jClient, process_callback, nullptr);
+    // prints the process callback timings every few seconds and on exit
+    if (app.arguments().contains("-profile"))
+        gProfiler.init(jClient);
+
+    jackbridge_set_process_callback(jClient, process_callback, &gEngine);
 #ifdef HAVE_JACKSESSION
     jackbridge_set_session_callback(jClient, session_callback, argv[0]);
 #endif
@@ -992,5 +992,8 @@ int main(int argc, char* argv[])
     jackbridge_deactivate(jClient);
     jackbridge_client_close(jClient);
 
+    if (gProfiler.isEnabled())
+        gProfiler.dump("process");
+
     return ret;
 }
@@ -15,14 +15,19 @@ VERSION  = 0.5.0
 
 SOURCES  = \
     xycontroller.cpp \
+    midiengine.cpp \
+    ../widgets/framescheduler.cpp \
     ../widgets/pixmapdial.cpp \
     ../widgets/pixmapkeyboard.cpp
 
 HEADERS  = \
+    ../jack_profiler.hpp \
     ../jack_utils.hpp \
-    ../midi_queue.hpp \
+    ../ring_buffer.hpp \
+    ../widgets/framescheduler.hpp \
     ../widgets/pixmapdial.hpp \
-    ../widgets/pixmapkeyboard.hpp
+    ../widgets/pixmapkeyboard.hpp \
+    midiengine.hpp
 
 INCLUDEPATH = \
     ../widgets